@@ -0,0 +1,79 @@
+#include "altitude.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace far::junior;
+
+namespace {
+
+double reference(double ratio)
+{
+  return BAROMETRIC_SCALE * (1.0 - std::pow(ratio, BAROMETRIC_EXPONENT));
+}
+
+template<typename Approximation>
+double max_error(const Approximation& approximation)
+{
+  double result = 0;
+  for(double ratio=MIN_PRESSURE_RATIO; ratio <= MAX_PRESSURE_RATIO; ratio += 0.0001)
+  {
+    result = std::max(result, std::abs(approximation(float(ratio)) - reference(float(ratio))));
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("Barometric altitude", "[altitude]")
+{
+  SECTION("The constexpr formula matches the runtime one")
+  {
+    constexpr auto altitude = barometric_altitude(0.9);
+    REQUIRE(altitude == Catch::Approx(reference(0.9)).epsilon(1e-12));
+    REQUIRE(barometric_altitude(1.0) == Catch::Approx(0.0).margin(1e-9));
+  }
+
+  SECTION("The table stays within its documented error")
+  {
+    constexpr AltitudeTable<> table;
+    REQUIRE(max_error(table) < 0.15);
+  }
+
+  SECTION("The polynomial stays within its documented error")
+  {
+    constexpr AltitudePolynomial<> polynomial;
+    REQUIRE(max_error(polynomial) < 0.005);
+  }
+
+  SECTION("Out of range ratios are clamped")
+  {
+    constexpr AltitudeTable<> table;
+    constexpr AltitudePolynomial<> polynomial;
+    REQUIRE(table(0.1f) == Catch::Approx(reference(MIN_PRESSURE_RATIO)).margin(0.1));
+    REQUIRE(polynomial(2.0f) == Catch::Approx(reference(MAX_PRESSURE_RATIO)).margin(0.1));
+  }
+
+  SECTION("Conversion is relative to the ground pressure")
+  {
+    const BarometricAltitude<> altitude{1000.0f};
+    const BarometricAltitude<AltitudeTable<>> table_altitude{1000.0f};
+    REQUIRE(altitude(1000.0f) == Catch::Approx(0.0).margin(0.005));
+    REQUIRE(altitude(950.0f) == Catch::Approx(reference(0.95)).margin(0.005));
+    REQUIRE(table_altitude(950.0f) == Catch::Approx(reference(0.95)).margin(0.15));
+
+    std::vector<float> pressures, altitudes(100);
+    for(int i=0; i < 100; ++i)
+    {
+      pressures.push_back(1000.0f - i * 3.0f);
+    }
+    altitude(pressures.begin(), pressures.end(), altitudes.begin());
+    for(int i=0; i < 100; ++i)
+    {
+      REQUIRE(altitudes[i] == altitude(pressures[i]));
+    }
+  }
+}
@@ -0,0 +1,168 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "constexpr-math.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace far::junior {
+
+// The international barometric formula, relative to the
+// pressure on the ground instead of the standard atmosphere:
+// h = BAROMETRIC_SCALE * (1 - (p / p0)^BAROMETRIC_EXPONENT)
+constexpr double BAROMETRIC_SCALE = 44330.77;
+constexpr double BAROMETRIC_EXPONENT = 0.190263;
+
+// The pressure ratios the approximations cover. That's
+// roughly -800m to 4100m relative to the ground, ratios
+// outside are clamped.
+constexpr double MIN_PRESSURE_RATIO = 0.6;
+constexpr double MAX_PRESSURE_RATIO = 1.1;
+
+// The exact formula, only meant for compile time and as reference.
+constexpr double barometric_altitude(double pressure_ratio)
+{
+  return BAROMETRIC_SCALE * (1.0 - deets::cmath::pow(pressure_ratio, BAROMETRIC_EXPONENT));
+}
+
+// Altitude from the pressure ratio by linear interpolation
+// in a table built at compile time. The interpolation error
+// is below h^2 / 8 * max|f''|, which for the default 64 points
+// is about 0.14m at the lowest ratio and 0.04m near the ground.
+template<typename F=float, size_t Points=64>
+class AltitudeTable
+{
+public:
+  static_assert(Points >= 2, "Need at least two points to interpolate");
+  static constexpr double STEP = (MAX_PRESSURE_RATIO - MIN_PRESSURE_RATIO) / (Points - 1);
+
+  constexpr AltitudeTable()
+  {
+    for(size_t i=0; i < Points; ++i)
+    {
+      _altitudes[i] = F(barometric_altitude(MIN_PRESSURE_RATIO + i * STEP));
+    }
+  }
+
+  F operator()(F pressure_ratio) const
+  {
+    const auto position = std::clamp(
+      (pressure_ratio - F(MIN_PRESSURE_RATIO)) * F(1.0 / STEP),
+      F(0), F(Points - 1)
+      );
+    const auto index = std::min(static_cast<size_t>(position), Points - 2);
+    const auto fraction = position - F(index);
+    return _altitudes[index] + (_altitudes[index + 1] - _altitudes[index]) * fraction;
+  }
+
+private:
+  std::array<F, Points> _altitudes{};
+};
+
+// Altitude from the pressure ratio through a polynomial, fitted
+// at compile time by interpolating in the Chebyshev nodes. That's
+// within a small factor of the minimax polynomial, and branch free
+// apart from the clamp, so the batch conversion vectorizes.
+// The default degree 6 stays within 4mm over the whole range,
+// float evaluation adds less than a millimeter on top.
+template<typename F=float, int Degree=6>
+class AltitudePolynomial
+{
+public:
+  static_assert(Degree >= 1, "Need at least a linear polynomial");
+  static constexpr double CENTER = (MAX_PRESSURE_RATIO + MIN_PRESSURE_RATIO) / 2;
+  static constexpr double HALF_WIDTH = (MAX_PRESSURE_RATIO - MIN_PRESSURE_RATIO) / 2;
+
+  constexpr AltitudePolynomial()
+  {
+    constexpr int NODES = Degree + 1;
+    std::array<double, NODES> chebyshev{};
+    for(int k=0; k < NODES; ++k)
+    {
+      const auto angle = deets::cmath::PI * (k + 0.5) / NODES;
+      const auto value = barometric_altitude(CENTER + HALF_WIDTH * deets::cmath::cos(angle));
+      for(int j=0; j < NODES; ++j)
+      {
+        chebyshev[j] += value * deets::cmath::cos(j * angle) * 2 / NODES;
+      }
+    }
+    chebyshev[0] /= 2;
+
+    // Expand into monomials through T(n+1) = 2t * T(n) - T(n-1)
+    std::array<double, NODES> previous{}, current{}, monomial{};
+    previous[0] = 1;
+    current[1] = 1;
+    monomial[0] = chebyshev[0];
+    for(int j=1; j < NODES; ++j)
+    {
+      for(int i=0; i < NODES; ++i)
+      {
+        monomial[i] += chebyshev[j] * current[i];
+      }
+      std::array<double, NODES> next{};
+      for(int i=0; i < NODES; ++i)
+      {
+        next[i] = (i > 0 ? 2 * current[i - 1] : 0.0) - previous[i];
+      }
+      previous = current;
+      current = next;
+    }
+    for(int i=0; i < NODES; ++i)
+    {
+      _coefficients[i] = F(monomial[i]);
+    }
+  }
+
+  F operator()(F pressure_ratio) const
+  {
+    const auto t = (std::clamp(pressure_ratio, F(MIN_PRESSURE_RATIO), F(MAX_PRESSURE_RATIO)) - F(CENTER))
+      * F(1.0 / HALF_WIDTH);
+    auto result = _coefficients[Degree];
+    for(int i=Degree - 1; i >= 0; --i)
+    {
+      result = result * t + _coefficients[i];
+    }
+    return result;
+  }
+
+private:
+  std::array<F, Degree + 1> _coefficients{};
+};
+
+// Converts pressure to altitude above the calibrated ground
+// pressure, typically JuniorRocketState::ground_pressure().
+template<typename Approximation=AltitudePolynomial<float>, typename F=float>
+class BarometricAltitude
+{
+public:
+  BarometricAltitude(F ground_pressure, Approximation approximation={})
+    : _inverse_ground_pressure(F(1) / ground_pressure)
+    , _approximation(approximation)
+  {}
+
+  F operator()(F pressure) const
+  {
+    return _approximation(pressure * _inverse_ground_pressure);
+  }
+
+  // Converts a whole log. Written as a plain loop over
+  // contiguous data so the compiler can vectorize it.
+  template<typename InputIt, typename OutputIt>
+  OutputIt operator()(InputIt first, InputIt last, OutputIt out) const
+  {
+    for(; first != last; ++first, ++out)
+    {
+      *out = (*this)(*first);
+    }
+    return out;
+  }
+
+private:
+  F _inverse_ground_pressure;
+  Approximation _approximation;
+};
+
+} // namespace far::junior
@@ -0,0 +1,158 @@
+#include "junior-rocket-state-impl.hpp"
+#include "synthetic-flight.hpp"
+#include "sample-queue.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace far::junior;
+
+namespace {
+
+struct Recorder
+{
+  void state_changed(timestamp_t timestamp, state to)
+  {
+    changes.push_back({timestamp, to});
+  }
+
+  void event_produced(timestamp_t, event e)
+  {
+    events.push_back(e);
+  }
+
+  std::vector<state_change_t> changes;
+  std::vector<event> events;
+};
+
+// Counts the samples the queue hands over per drive() call
+template<typename Detector>
+struct CountingDetector
+{
+  size_t drive(const sample_block_t& block, state_change_t* changes)
+  {
+    samples += block.size;
+    return detector.drive(block, changes);
+  }
+
+  Detector& detector;
+  size_t samples = 0;
+};
+
+} // namespace
+
+TEST_CASE("Block drive", "[drive]")
+{
+  const auto data = synthetic_flight();
+
+  Recorder per_sample;
+  BasicJuniorRocketState<Recorder> reference(per_sample);
+  drive(data, reference);
+  REQUIRE(per_sample.changes.size() > 5);
+
+  SECTION("The block drive reports the same state changes")
+  {
+    Recorder recorder;
+    BasicJuniorRocketState<Recorder> rocket(recorder);
+    const auto log = to_sample_log(data);
+    std::vector<state_change_t> changes(data.size());
+    changes.resize(rocket.drive(log.block(), changes.data()));
+    REQUIRE(changes == per_sample.changes);
+    REQUIRE(recorder.changes == per_sample.changes);
+    REQUIRE(recorder.events == per_sample.events);
+  }
+
+  SECTION("Blocks can be split anywhere")
+  {
+    Recorder recorder;
+    BasicJuniorRocketState<Recorder> rocket(recorder);
+    const auto log = to_sample_log(data);
+    std::vector<state_change_t> changes(data.size());
+    size_t count = 0;
+    for(size_t offset=0; offset < data.size(); offset += 37)
+    {
+      const auto size = std::min(size_t(37), data.size() - offset);
+      const sample_block_t block{
+        log.timestamps.data() + offset,
+        log.pressures.data() + offset,
+        log.accelerations.data() + offset,
+        size
+      };
+      count += rocket.drive(block, changes.data() + count);
+    }
+    changes.resize(count);
+    REQUIRE(changes == per_sample.changes);
+  }
+
+  SECTION("Samples can be handed over through the queue")
+  {
+    Recorder recorder;
+    BasicJuniorRocketState<Recorder> rocket(recorder);
+    SampleQueue<64, 16> queue;
+    std::vector<state_change_t> changes(data.size());
+    size_t count = 0;
+    // The main loop only gets to run every 50 samples
+    for(size_t i=0; i < data.size(); ++i)
+    {
+      REQUIRE(queue.push(data[i].time, data[i].pressure, data[i].totalacc));
+      if(i % 50 == 49)
+      {
+        count += queue.drive(rocket, changes.data() + count);
+      }
+    }
+    count += queue.drive(rocket, changes.data() + count);
+    changes.resize(count);
+    REQUIRE(changes == per_sample.changes);
+    REQUIRE(queue.overruns() == 0);
+    REQUIRE(queue.high_water_mark() == 50);
+  }
+
+  SECTION("A producer can keep pushing while the queue drives")
+  {
+    constexpr size_t CAPACITY = 16;
+    Recorder recorder;
+    BasicJuniorRocketState<Recorder> rocket(recorder);
+    CountingDetector<decltype(rocket)> counting{rocket};
+    SampleQueue<CAPACITY, 4> queue;
+    std::atomic<bool> done{false};
+    std::thread producer([&]()
+    {
+      for(const auto& row : data)
+      {
+        while(!queue.push(row.time, row.pressure, row.totalacc))
+        {
+          std::this_thread::yield();
+        }
+        std::this_thread::yield();
+      }
+      done = true;
+    });
+    std::vector<state_change_t> changes;
+    std::array<state_change_t, CAPACITY> buffer;
+    size_t max_samples = 0;
+    for(auto finished = false; !finished;)
+    {
+      // Only stop after a last drive once the producer is through
+      finished = done;
+      counting.samples = 0;
+      const auto count = queue.drive(counting, buffer.data());
+      changes.insert(changes.end(), buffer.begin(), buffer.begin() + count);
+      max_samples = std::max(max_samples, counting.samples);
+      std::this_thread::yield();
+    }
+    producer.join();
+    REQUIRE(max_samples <= CAPACITY);
+    REQUIRE(changes == per_sample.changes);
+  }
+
+  SECTION("The virtual adapter works through the simulator")
+  {
+    StateObserver nop;
+    JuniorRocketState rocket(nop);
+    REQUIRE(drive_block(to_sample_log(data), rocket) == per_sample.changes);
+  }
+}
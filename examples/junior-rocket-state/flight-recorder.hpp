@@ -0,0 +1,295 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "junior-rocket-state.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace far::junior {
+
+// The flight log is a sequence of fixed-size pages, so they map
+// directly onto flash pages. Each page holds one block:
+//
+//   magic (1) | payload length (2, LE) | CRC-32 of payload (4, LE) | payload
+//
+// and is padded with 0xFF, the erased flash state. The payload is
+// a stream of records, each starting with a varint of the time
+// delta in microseconds, shifted left by two with the record type
+// in the low bits. Samples follow with the zig-zag varint deltas
+// of the quantized pressure and acceleration, states and events
+// with a single byte. Deltas restart from zero in every block,
+// so a corrupt page only loses itself.
+namespace flight_log {
+
+constexpr size_t PAGE_SIZE = 256;
+constexpr uint8_t MAGIC = 0xFD;
+constexpr size_t HEADER_SIZE = 7;
+// Varint time plus two varint values
+constexpr size_t MAX_RECORD_SIZE = 10 + 5 + 5;
+// 0.001 mbar and 0.001 m/s^2, the resolution of the simulation data
+constexpr double PRESSURE_SCALE = 1000.0;
+constexpr double ACCELERATION_SCALE = 1000.0;
+
+enum class record_type : uint8_t
+{
+  SAMPLE,
+  STATE,
+  EVENT,
+};
+
+constexpr std::array<uint32_t, 256> crc_table()
+{
+  std::array<uint32_t, 256> table{};
+  for(uint32_t i=0; i < 256; ++i)
+  {
+    uint32_t crc = i;
+    for(int bit=0; bit < 8; ++bit)
+    {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+constexpr auto CRC_TABLE = crc_table();
+
+// The common CRC-32 (IEEE 802.3)
+inline uint32_t crc32(const uint8_t* data, size_t size)
+{
+  uint32_t crc = 0xFFFFFFFFu;
+  for(size_t i=0; i < size; ++i)
+  {
+    crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+inline uint32_t zigzag(int32_t value)
+{
+  return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t value)
+{
+  return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+inline uint8_t* put_varint(uint8_t* out, uint64_t value)
+{
+  while(value >= 0x80)
+  {
+    *out++ = uint8_t(value) | 0x80;
+    value >>= 7;
+  }
+  *out++ = uint8_t(value);
+  return out;
+}
+
+// Returns nullptr if the varint runs past end
+inline const uint8_t* get_varint(const uint8_t* in, const uint8_t* end, uint64_t& value)
+{
+  value = 0;
+  for(int shift=0; in != end && shift < 64; shift += 7)
+  {
+    const auto byte = *in++;
+    value |= uint64_t(byte & 0x7F) << shift;
+    if(!(byte & 0x80))
+    {
+      return in;
+    }
+  }
+  return nullptr;
+}
+
+struct decode_result_t
+{
+  size_t blocks = 0;
+  size_t corrupt_blocks = 0;
+};
+
+// Streams a flight log back. The visitor gets
+// sample(us, pressure, acceleration), state(us, state) and
+// event(us, event) calls, with microseconds since the first
+// recorded timestamp. Corrupt blocks are skipped and counted.
+template<size_t PageSize, typename Visitor>
+decode_result_t decode(const uint8_t* data, size_t size, Visitor& visitor)
+{
+  decode_result_t result;
+  for(size_t offset=0; offset + PageSize <= size; offset += PageSize)
+  {
+    const auto page = data + offset;
+    const size_t length = page[1] | (page[2] << 8);
+    const uint32_t crc = page[3] | (page[4] << 8) | (page[5] << 16) | (uint32_t(page[6]) << 24);
+    ++result.blocks;
+    if(page[0] != MAGIC || length > PageSize - HEADER_SIZE || crc32(page + HEADER_SIZE, length) != crc)
+    {
+      ++result.corrupt_blocks;
+      continue;
+    }
+    const uint8_t* in = page + HEADER_SIZE;
+    const uint8_t* end = in + length;
+    uint64_t time = 0;
+    int64_t pressure = 0, acceleration = 0;
+    while(in && in != end)
+    {
+      uint64_t tagged;
+      in = get_varint(in, end, tagged);
+      if(!in)
+      {
+        break;
+      }
+      time += tagged >> 2;
+      switch(record_type(tagged & 3))
+      {
+      case record_type::SAMPLE:
+      {
+        uint64_t dp = 0, da = 0;
+        in = get_varint(in, end, dp);
+        in = in ? get_varint(in, end, da) : nullptr;
+        if(in)
+        {
+          pressure += unzigzag(uint32_t(dp));
+          acceleration += unzigzag(uint32_t(da));
+          visitor.sample(time, float(pressure / PRESSURE_SCALE), float(acceleration / ACCELERATION_SCALE));
+        }
+        break;
+      }
+      case record_type::STATE:
+        if(in != end)
+        {
+          visitor.state(time, static_cast<far::junior::state>(*in++));
+        }
+        break;
+      case record_type::EVENT:
+        if(in != end)
+        {
+          visitor.event(time, static_cast<far::junior::event>(*in++));
+        }
+        break;
+      default:
+        in = nullptr;
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace flight_log
+
+// Records every sample, state change and event into page-sized
+// blocks, see flight_log for the format. Only one page is
+// buffered, each full page goes to the sink, a callable taking
+// (const uint8_t* page, size_t size), e.g. a flash page write.
+// Call flush() after the flight to write the last partial page.
+template<typename Sink, size_t PageSize=flight_log::PAGE_SIZE>
+class FlightRecorder final : public StateObserver
+{
+public:
+  static_assert(PageSize >= flight_log::HEADER_SIZE + flight_log::MAX_RECORD_SIZE, "Page too small for a record");
+  static_assert(PageSize - flight_log::HEADER_SIZE <= 0xFFFF, "Payload length must fit 16 bits");
+
+  FlightRecorder(Sink sink)
+    : _sink(sink)
+  {
+    reset();
+  }
+
+  void data(timestamp_t timestamp, float pressure, float acceleration) override
+  {
+    const auto p = int32_t(std::lround(double(pressure) * flight_log::PRESSURE_SCALE));
+    const auto a = int32_t(std::lround(double(acceleration) * flight_log::ACCELERATION_SCALE));
+    auto out = begin_record(timestamp, flight_log::record_type::SAMPLE);
+    out = flight_log::put_varint(out, flight_log::zigzag(p - _pressure));
+    out = flight_log::put_varint(out, flight_log::zigzag(a - _acceleration));
+    _pressure = p;
+    _acceleration = a;
+    _fill = size_t(out - _page.data());
+  }
+
+  void state_changed(timestamp_t timestamp, state to) override
+  {
+    auto out = begin_record(timestamp, flight_log::record_type::STATE);
+    *out++ = uint8_t(to);
+    _fill = size_t(out - _page.data());
+  }
+
+  void event_produced(timestamp_t timestamp, event e) override
+  {
+    auto out = begin_record(timestamp, flight_log::record_type::EVENT);
+    *out++ = uint8_t(e);
+    _fill = size_t(out - _page.data());
+  }
+
+  void flush()
+  {
+    if(_fill > flight_log::HEADER_SIZE)
+    {
+      write_page();
+    }
+  }
+
+  size_t pages_written() const { return _pages; }
+
+private:
+  uint8_t* begin_record(timestamp_t timestamp, flight_log::record_type type)
+  {
+    if(!_origin)
+    {
+      _origin = timestamp;
+    }
+    if(_fill + flight_log::MAX_RECORD_SIZE > PageSize)
+    {
+      write_page();
+    }
+    const uint64_t time = uint64_t((timestamp - *_origin) / std::chrono::microseconds(1));
+    const auto out = flight_log::put_varint(_page.data() + _fill, ((time - _time) << 2) | uint64_t(type));
+    _time = time;
+    return out;
+  }
+
+  void write_page()
+  {
+    const auto length = _fill - flight_log::HEADER_SIZE;
+    const auto crc = flight_log::crc32(_page.data() + flight_log::HEADER_SIZE, length);
+    _page[0] = flight_log::MAGIC;
+    _page[1] = uint8_t(length);
+    _page[2] = uint8_t(length >> 8);
+    for(int i=0; i < 4; ++i)
+    {
+      _page[3 + i] = uint8_t(crc >> (8 * i));
+    }
+    std::fill(_page.begin() + _fill, _page.end(), uint8_t(0xFF));
+    _sink(_page.data(), PageSize);
+    ++_pages;
+    reset();
+  }
+
+  // Every block starts from zero
+  void reset()
+  {
+    _fill = flight_log::HEADER_SIZE;
+    _time = 0;
+    _pressure = 0;
+    _acceleration = 0;
+  }
+
+  Sink _sink;
+  std::array<uint8_t, PageSize> _page;
+  size_t _fill;
+  size_t _pages = 0;
+  std::optional<timestamp_t> _origin;
+  uint64_t _time;
+  int32_t _pressure;
+  int32_t _acceleration;
+};
+
+} // namespace far::junior
@@ -0,0 +1,315 @@
+// Replays all bundled datasets and compares the state timelines
+// against the checked-in golden files, for the recorded data and
+// for a few hundred variants with added sensor noise. Set
+// JUNIOR_UPDATE_GOLDEN to rewrite them after an intended change
+// in detection.
+#include "simulator.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace far::junior;
+
+namespace {
+
+struct dataset_t {
+  const char* name;
+  const char* first_stage_file;
+  const char* second_stage_file;
+};
+
+const dataset_t DATASETS[] = {
+  {"junior3", "oberstufe-junior3.csv", "unterstufe-junior3.csv"},
+  {"no-drogue-junior3", "no-drogue-oberstufe-junior3.csv", "no-drogue-unterstufe-junior3.csv"},
+};
+
+constexpr int PERTURBED_VARIANTS = 200;
+// Roughly the noise of the barometer and accelerometer, as
+// standard deviation
+constexpr float PRESSURE_NOISE = 0.02f;
+constexpr float ACCELERATION_NOISE = 0.1f;
+// Timings besides the nominal ones the noise may push detection
+// to, e.g. the junior3 booster acceleration only just stays
+// above the freefall threshold after burnout, so noise makes
+// BURNOUT bimodal. More than that means the detection isn't
+// robust, and updating fails instead of pinning every variant.
+constexpr size_t MAX_ALTERNATIVES = 4;
+
+// How far a transition may move before it counts as a change in
+// detection. The timer driven ground states must not move at all,
+// the flight states by about a sample. Samples are 0.5s apart
+// under the drogue.
+duration_t tolerance(state s)
+{
+  switch(s)
+  {
+  case state::IDLE:
+  case state::ESTABLISH_GROUND_PRESSURE:
+  case state::WAIT_FOR_LAUNCH:
+    return 0ms;
+  case state::ACCELERATION_DETECTED:
+  case state::ACCELERATING:
+  case state::LAUNCHED:
+  case state::BURNOUT:
+  case state::SEPARATION:
+  case state::COASTING:
+    return 100ms;
+  default:
+    return 500ms;
+  }
+}
+
+using timeline_t = std::vector<state_change_t>;
+
+// The timeline of the recorded data, and the few alternative
+// timings noisy variants are allowed to show, e.g. an earlier
+// burnout. They all pass through the same states, noise must
+// never change the drogue verdict. Every variant has to stay
+// within the tolerances of one of them.
+struct golden_t {
+  timeline_t nominal;
+  std::vector<timeline_t> alternatives;
+};
+
+std::string data_path(const char* filename)
+{
+  return std::string(JUNIOR_SOURCE_DIR) + "/data/" + filename;
+}
+
+std::string golden_path(const std::string& name)
+{
+  return std::string(JUNIOR_SOURCE_DIR) + "/golden/" + name + ".timeline";
+}
+
+std::string file_name(const std::string& track_name)
+{
+  auto result = track_name;
+  std::replace(result.begin(), result.end(), ' ', '-');
+  return result;
+}
+
+// One transition per line, microseconds since the first sample
+void format(std::ostream& os, const timeline_t& changes, timestamp_t origin)
+{
+  for(const auto& change : changes)
+  {
+    os << (change.timestamp - origin) / 1us << " " << change.to << "\n";
+  }
+}
+
+void format(std::ostream& os, const golden_t& golden)
+{
+  os << "# nominal\n";
+  format(os, golden.nominal, timestamp_t{});
+  for(const auto& alternative : golden.alternatives)
+  {
+    os << "# alternative\n";
+    format(os, alternative, timestamp_t{});
+  }
+}
+
+golden_t parse(const std::string& text)
+{
+  std::vector<std::string> names;
+  for(int s=int(state::IDLE); s <= int(state::LANDED); ++s)
+  {
+    std::stringstream ss;
+    ss << state(s);
+    names.push_back(ss.str());
+  }
+  golden_t result;
+  timeline_t* current = &result.nominal;
+  std::stringstream ss(text);
+  for(std::string line; std::getline(ss, line);)
+  {
+    std::stringstream ls(line);
+    if(line == "# alternative")
+    {
+      current = &result.alternatives.emplace_back();
+      continue;
+    }
+    int64_t us;
+    std::string name;
+    if(line.empty() || line[0] == '#' || !(ls >> us >> name))
+    {
+      continue;
+    }
+    const auto pos = std::find(names.begin(), names.end(), name);
+    REQUIRE(pos != names.end());
+    current->push_back({timestamp_t{} + us * 1us, state(pos - names.begin())});
+  }
+  return result;
+}
+
+std::string read_file(const std::string& path)
+{
+  std::ifstream inf(path);
+  std::stringstream ss;
+  ss << inf.rdbuf();
+  return ss.str();
+}
+
+// Returns an empty string if the timelines match
+std::string compare(const timeline_t& golden, const timeline_t& actual, timestamp_t origin)
+{
+  std::stringstream ss;
+  if(golden.size() != actual.size())
+  {
+    ss << "Expected " << golden.size() << " transitions, got " << actual.size() << "\n";
+  }
+  for(size_t i=0; i < std::min(golden.size(), actual.size()); ++i)
+  {
+    const auto offset = actual[i].timestamp - origin;
+    const auto expected = golden[i].timestamp - timestamp_t{};
+    const auto deviation = offset > expected ? offset - expected : expected - offset;
+    if(golden[i].to != actual[i].to || deviation > tolerance(golden[i].to))
+    {
+      ss << "Transition " << i << ": expected " << golden[i].to << " at " << expected / 1us
+         << "us, got " << actual[i].to << " at " << offset / 1us << "us\n";
+    }
+  }
+  return ss.str();
+}
+
+// Whether both pass through the same states in the same
+// order, no matter when
+bool same_states(const timeline_t& a, const timeline_t& b)
+{
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+    [](const state_change_t& x, const state_change_t& y) { return x.to == y.to; });
+}
+
+// Returns an empty string if the timeline follows the nominal
+// states with the timing of one of the alternatives or the
+// nominal one, else how it differs from the latter.
+std::string compare(const golden_t& golden, const timeline_t& actual, timestamp_t origin)
+{
+  if(same_states(golden.nominal, actual))
+  {
+    for(const auto& alternative : golden.alternatives)
+    {
+      if(compare(alternative, actual, origin).empty())
+      {
+        return "";
+      }
+    }
+  }
+  return compare(golden.nominal, actual, origin);
+}
+
+// Uniform noise with the given standard deviation. Built from the
+// raw mt19937 output, which the standard fully specifies, unlike
+// the distributions. Integer arithmetic and one float scaling, so
+// every platform sees the same variants.
+class Noise
+{
+public:
+  Noise(unsigned seed)
+    : _generator(seed)
+  {}
+
+  float operator()(float deviation)
+  {
+    // Maps [0, 2^32) onto [-1, 1) in steps of 2^-31
+    const auto uniform = float(int64_t(_generator()) - (int64_t(1) << 31)) * 0x1p-31f;
+    return uniform * deviation * SQRT_3;
+  }
+
+private:
+  // The deviation of a uniform draw in [-1, 1) is 1 / sqrt(3)
+  static constexpr float SQRT_3 = 1.7320508f;
+  std::mt19937 _generator;
+};
+
+sample_log_t perturb(const sample_log_t& log, unsigned seed)
+{
+  Noise noise(seed);
+  auto result = log;
+  for(auto& pressure : result.pressures)
+  {
+    pressure += noise(PRESSURE_NOISE);
+  }
+  for(auto& acceleration : result.accelerations)
+  {
+    acceleration += noise(ACCELERATION_NOISE);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("Golden timelines", "[golden]")
+{
+  const auto update = std::getenv("JUNIOR_UPDATE_GOLDEN") != nullptr;
+
+  for(const auto& dataset : DATASETS)
+  {
+    const auto tracks = load_stages(
+      data_path(dataset.first_stage_file).c_str(),
+      data_path(dataset.second_stage_file).c_str()
+      );
+    for(const auto& track : tracks)
+    {
+      const auto name = std::string(dataset.name) + "." + file_name(track.name);
+      const auto origin = track.samples.timestamps.front();
+      INFO(name);
+
+      if(update)
+      {
+        golden_t golden;
+        golden.nominal = detect(track.samples);
+        for(auto& change : golden.nominal)
+        {
+          change.timestamp = timestamp_t{} + (change.timestamp - origin);
+        }
+        for(int variant=0; variant < PERTURBED_VARIANTS; ++variant)
+        {
+          const auto changes = detect(perturb(track.samples, unsigned(variant)));
+          if(compare(golden, changes, origin) != "")
+          {
+            INFO("Variant " << variant << " takes another path, the detection isn't robust against the noise\n"
+                 << compare(golden.nominal, changes, origin));
+            REQUIRE(same_states(golden.nominal, changes));
+            auto& recorded = golden.alternatives.emplace_back();
+            for(const auto& change : changes)
+            {
+              recorded.push_back({timestamp_t{} + (change.timestamp - origin), change.to});
+            }
+          }
+        }
+        INFO("Too many alternative paths, the detection isn't robust against the noise");
+        REQUIRE(golden.alternatives.size() <= MAX_ALTERNATIVES);
+        std::ofstream out(golden_path(name));
+        format(out, golden);
+        continue;
+      }
+
+      const auto golden = parse(read_file(golden_path(name)));
+      REQUIRE(!golden.nominal.empty());
+      for(const auto& alternative : golden.alternatives)
+      {
+        REQUIRE(same_states(golden.nominal, alternative));
+      }
+
+      // The recorded data must replay exactly
+      std::stringstream expected, actual;
+      format(expected, golden.nominal, timestamp_t{});
+      format(actual, detect(track.samples), origin);
+      REQUIRE(actual.str() == expected.str());
+
+      for(int variant=0; variant < PERTURBED_VARIANTS; ++variant)
+      {
+        INFO("Variant " << variant);
+        REQUIRE(compare(golden, detect(perturb(track.samples, unsigned(variant))), origin) == "");
+      }
+    }
+  }
+}
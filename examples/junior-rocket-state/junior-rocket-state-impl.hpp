@@ -0,0 +1,310 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "junior-rocket-state.hpp"
+
+namespace far::junior {
+
+template<typename Observer>
+BasicJuniorRocketState<Observer>::BasicJuniorRocketState(Observer& state_observer, const detector_parameters_t& parameters)
+  : _parameters(parameters)
+  , _state_machine(state::IDLE)
+  , _state_observer(state_observer)
+{
+  auto& sm = _state_machine; // Just a convenient alias
+  const auto& p = _parameters;
+  sm.add_transition(state::IDLE, duration_t::zero(), state::ESTABLISH_GROUND_PRESSURE);
+  sm.add_transition(state::ESTABLISH_GROUND_PRESSURE, event::GROUND_PRESSURE_ESTABLISHED, state::WAIT_FOR_LAUNCH);
+  sm.add_transition(state::WAIT_FOR_LAUNCH, event::ACCELERATION_ABOVE_THRESHOLD, state::ACCELERATION_DETECTED);
+  sm.add_transition(state::ACCELERATION_DETECTED, event::ACCELERATION_BELOW_THRESHOLD, state::WAIT_FOR_LAUNCH);
+  sm.add_transition(state::ACCELERATION_DETECTED, p.acceleration_timeout, state::ACCELERATING);
+  sm.add_transition(state::ACCELERATING, event::ACCELERATION_BELOW_THRESHOLD, state::WAIT_FOR_LAUNCH);
+  sm.add_transition(state::ACCELERATING, event::PRESSURE_BELOW_LAUNCH_THRESHOLD, state::LAUNCHED);
+  sm.add_transition(state::LAUNCHED, event::ACCELERATION_AROUND_ZERO, state::BURNOUT);
+  sm.add_transition(state::LAUNCHED, p.motor_burntime - p.acceleration_timeout, state::BURNOUT);
+  sm.add_transition(state::BURNOUT, p.separation_timeout, state::SEPARATION);
+  sm.add_transition(state::SEPARATION, duration_t::zero(), state::COASTING);
+  sm.add_transition(state::COASTING, event::PRESSURE_PEAK_REACHED, state::FALLING_);
+  sm.add_transition(state::COASTING, event::EXPECTED_APOGEE_TIME_REACHED, state::FALLING_);
+  sm.add_transition(state::FALLING_, p.falling_pressure_timeout, state::MEASURE_FALLING_PRESSURE1);
+  sm.add_transition(state::MEASURE_FALLING_PRESSURE1, p.falling_pressure_timeout, state::MEASURE_FALLING_PRESSURE2);
+  sm.add_transition(state::MEASURE_FALLING_PRESSURE2, p.falling_pressure_timeout, state::MEASURE_FALLING_PRESSURE3);
+  sm.add_transition(state::MEASURE_FALLING_PRESSURE3, event::PRESSURE_LINEAR, state::DROUGE_OPENED);
+  sm.add_transition(state::MEASURE_FALLING_PRESSURE3, event::PRESSURE_QUADRATIC, state::DROUGE_FAILED);
+  sm.add_transition(state::DROUGE_OPENED, event::PRESSURE_ABOVE_LAUNCH_THRESHOLD, state::LANDED);
+  sm.add_transition(state::DROUGE_FAILED, event::PRESSURE_ABOVE_LAUNCH_THRESHOLD, state::LANDED);
+  sm.add_transition(state::DROUGE_FAILED, event::RESTART_PRESSURE_MEASUREMENT, state::FALLING_);
+}
+
+
+template<typename Observer>
+template<typename... Args>
+void BasicJuniorRocketState<Observer>::debug(message m, Args... args)
+{
+  if(const auto log = hooks::log(_state_observer))
+  {
+    log->debug(m, args...);
+  }
+}
+
+template<typename Observer>
+std::optional<float> BasicJuniorRocketState<Observer>::ground_pressure() const
+{
+  return _ground_pressure;
+}
+
+template<typename Observer>
+const detector_parameters_t& BasicJuniorRocketState<Observer>::parameters() const
+{
+  return _parameters;
+}
+
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::process_pressure(timestamp_t timestamp, float pressure)
+{
+  if(_ground_pressure_stats)
+  {
+    const auto stats = _ground_pressure_stats->update(pressure);
+    if(stats)
+    {
+      debug(message::PRESSURE_STATS, stats->average, stats->variance);
+      if(stats->variance < _parameters.pressure_variance_threshold)
+      {
+        _ground_pressure = stats->average;
+      }
+    }
+  }
+  if(_pressure_drop_fit)
+  {
+    const auto since_falling = std::chrono::duration<double>(timestamp - _pressure_drop_start).count();
+    _pressure_drop_fit->update(since_falling, pressure);
+  }
+  if(_peak_pressure_stats)
+  {
+    if(_peak_pressure_stats->update(pressure))
+    {
+      if(_peak_pressure)
+      {
+        const auto median = *_peak_pressure_stats->median();
+        debug(message::PEAK_PRESSURE_MEDIAN, median);
+        _peak_pressure = std::min(median, *_peak_pressure);
+      }
+      else
+      {
+        _peak_pressure = *_peak_pressure_stats->median();
+      }
+      debug(message::PEAK_PRESSURE, *_peak_pressure);
+    }
+  }
+}
+
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::produce_events(timestamp_t timestamp, float pressure, float acceleration)
+{
+  if(_ground_pressure) {
+    feed(timestamp, event::GROUND_PRESSURE_ESTABLISHED);
+    if(*_ground_pressure - pressure >= _parameters.launch_pressure_differential)
+    {
+      feed(timestamp, event::PRESSURE_BELOW_LAUNCH_THRESHOLD);
+    }
+    else
+    {
+      feed(timestamp, event::PRESSURE_ABOVE_LAUNCH_THRESHOLD);
+    }
+  }
+
+  if(acceleration > _parameters.launch_acceleration_threshold)
+  {
+    feed(timestamp, event::ACCELERATION_ABOVE_THRESHOLD);
+  }
+  else
+  {
+    feed(timestamp, event::ACCELERATION_BELOW_THRESHOLD);
+    if(acceleration < _parameters.freefall_acceleration_threshold)
+    {
+      feed(timestamp, event::ACCELERATION_AROUND_ZERO);
+    }
+  }
+
+  if(_peak_pressure && pressure > *_peak_pressure + _parameters.peak_pressure_margin)
+  {
+    feed(timestamp, event::PRESSURE_PEAK_REACHED);
+  }
+
+  if(flighttime() && *flighttime() >= (_parameters.apogee_time + _parameters.apogee_detection_margin))
+  {
+    feed(timestamp, event::EXPECTED_APOGEE_TIME_REACHED);
+  }
+
+  if(_pressure_drop_assessment)
+  {
+    switch(*_pressure_drop_assessment)
+    {
+    case pressure_drop::LINEAR:
+      feed(timestamp, event::PRESSURE_LINEAR);
+      break;
+    case pressure_drop::QUADRATIC:
+      feed(timestamp, event::PRESSURE_QUADRATIC);
+      break;
+    }
+    // We need to re-measure
+    _pressure_drop_assessment = std::nullopt;
+  }
+}
+
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::feed(timestamp_t timestamp, event e)
+{
+  _state_machine.feed(e);
+  hooks::event_produced(_state_observer, timestamp, e);
+}
+
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::handle_state_transition(state to)
+{
+  switch(to)
+  {
+  case state::ESTABLISH_GROUND_PRESSURE:
+    // This kicks of the statistics of the ground pressure calibration
+    _ground_pressure_stats.emplace();
+    break;
+  case state::WAIT_FOR_LAUNCH:
+    _liftoff_timestamp = std::nullopt;
+    // no need to feed the machine again
+    _ground_pressure_stats = std::nullopt;
+    break;
+  case state::ACCELERATION_DETECTED:
+    _liftoff_timestamp = *_last_timestamp;
+    break;
+  case state::LAUNCHED:
+    _peak_pressure_stats.emplace();
+    break;
+  case state::FALLING_:
+    // We don't need to keep track anymore
+    _peak_pressure_stats = std::nullopt;
+    // Fit all samples until MEASURE_FALLING_PRESSURE3, only
+    // the last PRESSURE_DROP_WINDOW of them count.
+    _pressure_drop_fit.emplace();
+    _pressure_drop_start = *_last_timestamp;
+    break;
+  case state::MEASURE_FALLING_PRESSURE3:
+    assess_pressure_drop();
+    break;
+  default:
+    break;
+  }
+}
+
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::assess_pressure_drop()
+{
+  const auto fit = _pressure_drop_fit->result();
+  _pressure_drop_fit = std::nullopt;
+  // Too few samples to tell, assume the drogue is out
+  if(!fit)
+  {
+    _pressure_drop_assessment = pressure_drop::LINEAR;
+    return;
+  }
+  debug(message::PRESSURE_DROP_FIT, fit->b, fit->second_derivative(), fit->f_statistic);
+  // The curvature has to be both significant and big enough
+  // to be free fall, the noise alone can't trigger it, and
+  // neither can the last bit of deceleration under the drogue.
+  const auto quadratic = fit->f_statistic > _parameters.pressure_drop_significance
+    && fit->second_derivative() > _parameters.pressure_drop_curvature;
+  _pressure_drop_assessment = quadratic ? pressure_drop::QUADRATIC : pressure_drop::LINEAR;
+}
+
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::drive(timestamp_t timestamp, float pressure, float acceleration)
+{
+  hooks::data(_state_observer, timestamp, pressure, acceleration);
+  if(!_last_timestamp)
+  {
+    start(timestamp);
+    return;
+  }
+  step(timestamp, pressure, acceleration);
+}
+
+template<typename Observer>
+size_t BasicJuniorRocketState<Observer>::drive(const sample_block_t& block, state_change_t* changes)
+{
+  size_t count = 0;
+  size_t i = 0;
+  if(!_last_timestamp && block.size)
+  {
+    hooks::data(_state_observer, block.timestamps[0], block.pressures[0], block.accelerations[0]);
+    start(block.timestamps[0]);
+    changes[count++] = {block.timestamps[0], _state_machine.state()};
+    ++i;
+  }
+  // From here on there's always a previous timestamp
+  for(; i < block.size; ++i)
+  {
+    const auto timestamp = block.timestamps[i];
+    hooks::data(_state_observer, timestamp, block.pressures[i], block.accelerations[i]);
+    if(step(timestamp, block.pressures[i], block.accelerations[i]))
+    {
+      changes[count++] = {timestamp, _state_machine.state()};
+    }
+  }
+  return count;
+}
+
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::start(timestamp_t timestamp)
+{
+  _last_timestamp = timestamp;
+  // Initial call of state observer for our start-state
+  hooks::state_changed(_state_observer, timestamp, _state_machine.state());
+}
+
+template<typename Observer>
+bool BasicJuniorRocketState<Observer>::step(timestamp_t timestamp, float pressure, float acceleration)
+{
+  // TODO: timediff!
+  const auto elapsed = timestamp - *_last_timestamp;
+  _last_timestamp = timestamp;
+  process_pressure(timestamp, pressure);
+
+  const auto old = _state_machine.state();
+
+  // Drive timer events
+  _state_machine.elapsed(elapsed);
+  hooks::elapsed(_state_observer, timestamp, elapsed);
+
+  produce_events(timestamp, pressure, acceleration);
+
+  const auto to = _state_machine.state();
+  if(old != to)
+  {
+    handle_state_transition(to);
+    hooks::state_changed(_state_observer, timestamp, to);
+    return true;
+  }
+  return false;
+}
+
+template<typename Observer>
+std::optional<duration_t> BasicJuniorRocketState<Observer>::flighttime() const
+{
+  if(_liftoff_timestamp)
+  {
+    // We know _last_timestamp must be valid, as
+    // no liftoff could exist otherwise
+    return *_last_timestamp - *_liftoff_timestamp;
+  }
+  return std::nullopt;
+}
+
+#ifdef USE_IOSTREAM
+template<typename Observer>
+void BasicJuniorRocketState<Observer>::dot(std::ostream &os)
+{
+  _state_machine.dot(os, "us");
+}
+#endif
+
+} // namespace far::junior
@@ -20,9 +20,14 @@ std::ostream& operator<<(std::ostream&, const far::junior::duration_t&);
 }
 
 #include "timed-finite-automaton.hpp"
+#include "log.hpp"
 #include "statistics.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace far::junior {
 
@@ -98,6 +103,33 @@ constexpr duration_t APOGEE_TIME = 6565ms;
 constexpr duration_t APOGEE_DETECTION_MARGIN = 5s;
 constexpr float INITIAL_PRESSURE_VARIANCE = 1.0;
 constexpr float PRESSURE_VARIANCE_THRESHOLD = 3.0;
+// The pressure fit after apogee covers the last samples before
+// MEASURE_FALLING_PRESSURE3, 2.8s of the 3s span at 20Hz. Noise
+// easily bends a shorter one enough to flip the verdict.
+constexpr int PRESSURE_DROP_WINDOW = 56;
+// F(1, PRESSURE_DROP_WINDOW - 3) at 99% confidence
+constexpr float PRESSURE_DROP_SIGNIFICANCE = 7.14;
+// Free fall increases pressure by about 1.2 mbar/s^2 near
+// the ground, a drogue descent keeps it close to zero.
+constexpr float PRESSURE_DROP_CURVATURE = 0.4;
+
+// The tunable part of the detection, by default the constants
+// above. A sweep can evaluate other values without recompiling.
+struct detector_parameters_t {
+  float launch_acceleration_threshold = LAUNCH_ACCELERATION_THRESHOLD;
+  float freefall_acceleration_threshold = FREEFALL_ACCELERATION_THRESHOLD;
+  float launch_pressure_differential = LAUNCH_PRESSURE_DIFFERENTIAL;
+  float peak_pressure_margin = PEAK_PRESSURE_MARGIN;
+  duration_t apogee_time = APOGEE_TIME;
+  duration_t apogee_detection_margin = APOGEE_DETECTION_MARGIN;
+  float pressure_variance_threshold = PRESSURE_VARIANCE_THRESHOLD;
+  float pressure_drop_significance = PRESSURE_DROP_SIGNIFICANCE;
+  float pressure_drop_curvature = PRESSURE_DROP_CURVATURE;
+  duration_t acceleration_timeout = timeouts::ACCELERATION;
+  duration_t separation_timeout = timeouts::SEPARATION_TIMEOUT;
+  duration_t motor_burntime = timeouts::MOTOR_BURNTIME;
+  duration_t falling_pressure_timeout = timeouts::FALLING_PRESSURE_TIMEOUT;
+};
 
 enum class event {
   GROUND_PRESSURE_ESTABLISHED,
@@ -141,46 +173,220 @@ struct StateObserver {
     M_UNUSED(timestamp);
     M_UNUSED(elapsed);
   }
+
+  // Where the detector writes its debug log, null for nowhere
+  virtual Log* log()
+  {
+    return nullptr;
+  }
+};
+
+// Observers are called through static dispatch. Any type can be
+// an observer, a hook is only called if the observer has it, so
+// e.g. one only listening to state_changed costs nothing per
+// sample. StateObserver is the virtual adapter for runtime
+// polymorphism.
+namespace hooks {
+
+template<typename O, typename=void>
+struct has_data : std::false_type {};
+template<typename O>
+struct has_data<O, std::void_t<decltype(std::declval<O&>().data(timestamp_t{}, 0.0f, 0.0f))>> : std::true_type {};
+
+template<typename O, typename=void>
+struct has_state_changed : std::false_type {};
+template<typename O>
+struct has_state_changed<O, std::void_t<decltype(std::declval<O&>().state_changed(timestamp_t{}, state{}))>> : std::true_type {};
+
+template<typename O, typename=void>
+struct has_event_produced : std::false_type {};
+template<typename O>
+struct has_event_produced<O, std::void_t<decltype(std::declval<O&>().event_produced(timestamp_t{}, event{}))>> : std::true_type {};
+
+template<typename O, typename=void>
+struct has_elapsed : std::false_type {};
+template<typename O>
+struct has_elapsed<O, std::void_t<decltype(std::declval<O&>().elapsed(timestamp_t{}, duration_t{}))>> : std::true_type {};
+
+template<typename O, typename=void>
+struct has_log : std::false_type {};
+template<typename O>
+struct has_log<O, std::void_t<decltype(std::declval<O&>().log())>> : std::true_type {};
+
+template<typename O>
+void data(O& observer, timestamp_t timestamp, float pressure, float acceleration)
+{
+  if constexpr (has_data<O>::value)
+  {
+    observer.data(timestamp, pressure, acceleration);
+  }
+}
+
+template<typename O>
+void state_changed(O& observer, timestamp_t timestamp, state to)
+{
+  if constexpr (has_state_changed<O>::value)
+  {
+    observer.state_changed(timestamp, to);
+  }
+}
+
+template<typename O>
+void event_produced(O& observer, timestamp_t timestamp, event e)
+{
+  if constexpr (has_event_produced<O>::value)
+  {
+    observer.event_produced(timestamp, e);
+  }
+}
+
+template<typename O>
+void elapsed(O& observer, timestamp_t timestamp, duration_t elapsed)
+{
+  if constexpr (has_elapsed<O>::value)
+  {
+    observer.elapsed(timestamp, elapsed);
+  }
+}
+
+// The log of the observer. Whoever provides it also drains
+// it, without one the detector doesn't log at all.
+template<typename O>
+Log* log(O& observer)
+{
+  if constexpr (has_log<O>::value)
+  {
+    return observer.log();
+  }
+  return nullptr;
+}
+
+} // namespace hooks
+
+// Fans out to several observers without a virtual hop, each
+// only getting the hooks it has.
+template<typename... Observers>
+struct ObserverSet
+{
+  ObserverSet(Observers&... observers_)
+    : observers(observers_...)
+  {}
+
+  void data(timestamp_t timestamp, float pressure, float acceleration)
+  {
+    std::apply([&](auto&... o) { (hooks::data(o, timestamp, pressure, acceleration), ...); }, observers);
+  }
+
+  void state_changed(timestamp_t timestamp, state to)
+  {
+    std::apply([&](auto&... o) { (hooks::state_changed(o, timestamp, to), ...); }, observers);
+  }
+
+  void event_produced(timestamp_t timestamp, event e)
+  {
+    std::apply([&](auto&... o) { (hooks::event_produced(o, timestamp, e), ...); }, observers);
+  }
+
+  void elapsed(timestamp_t timestamp, duration_t elapsed)
+  {
+    std::apply([&](auto&... o) { (hooks::elapsed(o, timestamp, elapsed), ...); }, observers);
+  }
+
+  // The first log one of the observers provides
+  Log* log()
+  {
+    Log* result = nullptr;
+    std::apply([&](auto&... o) { ((result = result ? result : hooks::log(o)), ...); }, observers);
+    return result;
+  }
+
+  std::tuple<Observers&...> observers;
 };
 
+template<typename... Observers>
+ObserverSet(Observers&...) -> ObserverSet<Observers...>;
+
+
+// A block of samples in structure of arrays layout, as they
+// come from a replay log or a DMA buffer.
+struct sample_block_t
+{
+  const timestamp_t* timestamps;
+  const float* pressures;
+  const float* accelerations;
+  size_t size;
+};
 
-class JuniorRocketState {
+struct state_change_t
+{
+  timestamp_t timestamp;
+  state to;
+
+  bool operator==(const state_change_t& other) const
+  {
+    return timestamp == other.timestamp && to == other.to;
+  }
+};
+
+// The member definitions live in junior-rocket-state-impl.hpp,
+// include that to use your own observer type. The StateObserver
+// version is compiled once in junior-rocket-state.cpp.
+template<typename Observer>
+class BasicJuniorRocketState {
   using state_machine_t = tfa::TimedFiniteAutomaton<state, event, timestamp_t>;
 
 public:
 
-  JuniorRocketState(StateObserver&);
-  JuniorRocketState(const JuniorRocketState&) = delete;
-  JuniorRocketState& operator=(const JuniorRocketState&) = delete;
-  JuniorRocketState(JuniorRocketState&&) = delete;
+  BasicJuniorRocketState(Observer&, const detector_parameters_t& parameters={});
+  BasicJuniorRocketState(const BasicJuniorRocketState&) = delete;
+  BasicJuniorRocketState& operator=(const BasicJuniorRocketState&) = delete;
+  BasicJuniorRocketState(BasicJuniorRocketState&&) = delete;
 
   void dot(std::ostream& os);
   void drive(timestamp_t, float, float);
+  // Drives a whole block, same as calling drive() per sample.
+  // Writes the state changes the observer sees to changes,
+  // which needs room for block.size entries, and returns
+  // their number.
+  size_t drive(const sample_block_t& block, state_change_t* changes);
   std::optional<duration_t> flighttime() const;
   std::optional<float> ground_pressure() const;
+  const detector_parameters_t& parameters() const;
 
 private:
-  void process_pressure(float pressure);
+  void start(timestamp_t timestamp);
+  // Returns if the state changed
+  bool step(timestamp_t timestamp, float pressure, float acceleration);
+  void process_pressure(timestamp_t timestamp, float pressure);
   void produce_events(timestamp_t timestamp, float pressure, float acceleration);
-  void handle_state_transition(state to, float pressure);
+  void handle_state_transition(state to);
   void feed(timestamp_t timestamp, event);
   void assess_pressure_drop();
+  template<typename... Args>
+  void debug(message, Args...);
 
+  detector_parameters_t _parameters;
   state_machine_t _state_machine;
 
   std::optional<timestamp_t> _last_timestamp;
   std::optional<float> _ground_pressure;
   std::optional<timestamp_t> _liftoff_timestamp;
 
-  StateObserver& _state_observer;
+  Observer& _state_observer;
 
   std::optional<deets::statistics::ArrayStatistics<float, 2>> _ground_pressure_stats;
   std::optional<deets::statistics::ArrayStatistics<float, 10>> _peak_pressure_stats;
-  float _pressure_measurements[3];
+  // In double, as on clean data the residuals of line and
+  // parabola only differ beyond float precision.
+  std::optional<deets::statistics::RollingQuadraticFit<double, PRESSURE_DROP_WINDOW>> _pressure_drop_fit;
+  timestamp_t _pressure_drop_start;
   std::optional<pressure_drop> _pressure_drop_assessment;
   std::optional<float> _peak_pressure;
 };
 
+using JuniorRocketState = BasicJuniorRocketState<StateObserver>;
+extern template class BasicJuniorRocketState<StateObserver>;
+
 #ifdef USE_IOSTREAM
 // To allow graphviz output
 std::ostream& operator<<(std::ostream&, const state&);
@@ -0,0 +1,173 @@
+#include "kalman.hpp"
+#include "altitude.hpp"
+#include "latency.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <string>
+
+using namespace far::junior;
+
+namespace {
+
+// A deterministic stand in for sensor noise in [-1, 1]
+double noise(int i)
+{
+  return std::sin(i * 12.9898) * 0.5 + std::sin(i * 78.233) * 0.5;
+}
+
+std::string data_path(const char* filename)
+{
+  return std::string(JUNIOR_SOURCE_DIR) + "/data/" + filename;
+}
+
+template<typename Scalar>
+void fly(AltitudeKalmanFilter<Scalar>& filter, acceleration_frame frame, double& apogee_time, double& estimated_apogee_time, double& max_velocity_error)
+{
+  constexpr double g = AltitudeKalmanFilter<double>::GRAVITY;
+  constexpr double burn_time = 2.0;
+  constexpr double thrust_acceleration = 60.0;
+  constexpr double bias = 0.3;
+  double altitude = 0, velocity = 0, t = 0;
+  apogee_time = estimated_apogee_time = -1;
+  max_velocity_error = 0;
+  for(int i=1; t < 20.0; ++i)
+  {
+    // The period jumps around like it does on the real thing
+    const auto dt = i % 3 ? 0.005 : 0.03;
+    t += dt;
+    const auto acceleration = (t < burn_time ? thrust_acceleration : 0.0) - g;
+    altitude += velocity * dt + acceleration * dt * dt / 2;
+    velocity += acceleration * dt;
+    if(apogee_time < 0 && velocity < 0)
+    {
+      apogee_time = t;
+    }
+    const auto measured = acceleration + bias + 0.5 * noise(i + 7)
+      + (frame == acceleration_frame::SPECIFIC_FORCE ? g : 0.0);
+    filter.update(Scalar(dt), Scalar(altitude + 2.0 * noise(i)), Scalar(measured));
+    if(estimated_apogee_time < 0 && filter.descending())
+    {
+      estimated_apogee_time = t;
+    }
+    if(t > 1.0)
+    {
+      max_velocity_error = std::max(max_velocity_error, std::abs(filter.velocity() - velocity));
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("Altitude Kalman filter", "[kalman]")
+{
+  const AltitudeKalmanFilter<double>::parameters_t parameters{acceleration_frame::VERTICAL, 1.0, 0.1, 2.0};
+
+  SECTION("The gain settles and stays sane")
+  {
+    AltitudeKalmanFilter<double> filter{parameters};
+    for(int i=0; i < 1000; ++i)
+    {
+      filter.update(0.01, 0.0, 0.0);
+    }
+    REQUIRE(filter.gain()(0) > 0);
+    REQUIRE(filter.gain()(0) < 1);
+    REQUIRE(filter.covariance()(0, 0) < 4.0);
+    REQUIRE(filter.covariance() == filter.covariance().transpose());
+  }
+
+  SECTION("Velocity is tracked and apogee detected close to the truth")
+  {
+    AltitudeKalmanFilter<double> filter{parameters};
+    double apogee_time, estimated_apogee_time, max_velocity_error;
+    fly(filter, acceleration_frame::VERTICAL, apogee_time, estimated_apogee_time, max_velocity_error);
+    REQUIRE(apogee_time > 0);
+    REQUIRE(estimated_apogee_time == Catch::Approx(apogee_time).margin(0.2));
+    REQUIRE(max_velocity_error < 2.0);
+  }
+
+  SECTION("The float path works just as well")
+  {
+    AltitudeKalmanFilter<float> filter{{acceleration_frame::VERTICAL, 1.0f, 0.1f, 2.0f}};
+    double apogee_time, estimated_apogee_time, max_velocity_error;
+    fly(filter, acceleration_frame::VERTICAL, apogee_time, estimated_apogee_time, max_velocity_error);
+    REQUIRE(estimated_apogee_time == Catch::Approx(apogee_time).margin(0.2));
+    REQUIRE(max_velocity_error < 2.0);
+  }
+
+  SECTION("The precomputed gain is where the online one settles")
+  {
+    auto fixed = parameters;
+    fixed.period = 0.01;
+    AltitudeKalmanFilter<double> steady{fixed};
+    AltitudeKalmanFilter<double> online{parameters};
+    for(int i=0; i < 5000; ++i)
+    {
+      online.update(0.01, 0.0, 0.0);
+    }
+    for(int i=0; i < 3; ++i)
+    {
+      REQUIRE(steady.steady_state_gain()(i) == Catch::Approx(online.gain()(i)));
+    }
+  }
+
+  SECTION("At a nominal period, jittered samples fall back to the online gain")
+  {
+    // Two in three samples are at the period
+    AltitudeKalmanFilter<float> filter{{acceleration_frame::VERTICAL, 1.0f, 0.1f, 2.0f, 0.005f}};
+    double apogee_time, estimated_apogee_time, max_velocity_error;
+    fly(filter, acceleration_frame::VERTICAL, apogee_time, estimated_apogee_time, max_velocity_error);
+    REQUIRE(estimated_apogee_time == Catch::Approx(apogee_time).margin(0.2));
+    REQUIRE(max_velocity_error < 2.0);
+  }
+
+  SECTION("An accelerometer reading including gravity is corrected")
+  {
+    AltitudeKalmanFilter<float> filter{{acceleration_frame::SPECIFIC_FORCE, 1.0f, 0.1f, 2.0f}};
+    double apogee_time, estimated_apogee_time, max_velocity_error;
+    fly(filter, acceleration_frame::SPECIFIC_FORCE, apogee_time, estimated_apogee_time, max_velocity_error);
+    REQUIRE(estimated_apogee_time == Catch::Approx(apogee_time).margin(0.2));
+    REQUIRE(max_velocity_error < 2.0);
+  }
+}
+
+TEST_CASE("Altitude Kalman filter on simulation data", "[kalman]")
+{
+  // The full flight of the upper stage, with periods from 1ms
+  // to 500ms and only the magnitude of the acceleration.
+  const auto tracks = load_stages(
+    data_path("unterstufe-junior3.csv").c_str(),
+    data_path("oberstufe-junior3.csv").c_str()
+    );
+  const auto& track = tracks[1];
+  const auto& samples = track.samples;
+  const auto apogee = std::find_if(track.events.begin(), track.events.end(),
+    [](const flight_event_t& e) { return e.name == "APOGEE"; });
+  REQUIRE(apogee != track.events.end());
+
+  const BarometricAltitude<> barometer{samples.pressures.front()};
+  AltitudeKalmanFilter<float> filter{{acceleration_frame::MAGNITUDE, 1.0f, 0.1f, 0.5f}};
+  std::optional<timestamp_t> detected;
+  float peak = 0;
+  for(size_t i=1; i < samples.timestamps.size(); ++i)
+  {
+    const auto dt = std::chrono::duration<float>(samples.timestamps[i] - samples.timestamps[i - 1]).count();
+    filter.update(dt, barometer(samples.pressures[i]), samples.accelerations[i]);
+    REQUIRE(std::isfinite(filter.velocity()));
+    peak = std::max(peak, filter.velocity());
+    // Only look once we're clearly off the pad
+    if(!detected && filter.altitude() > 50 && filter.descending())
+    {
+      detected = samples.timestamps[i];
+    }
+  }
+  REQUIRE(peak > 50);
+  REQUIRE(detected);
+  const auto error = std::chrono::duration<float>(*detected - apogee->time).count();
+  REQUIRE(std::abs(error) < 1.0f);
+}
@@ -0,0 +1,230 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <Eigen/Eigen>
+
+#include <algorithm>
+#include <cmath>
+
+namespace far::junior {
+
+// What the acceleration passed to the filter means.
+enum class acceleration_frame {
+  // Signed vertical acceleration, positive up, gravity removed.
+  VERTICAL,
+  // Signed reading of an accelerometer pointing up, which
+  // includes gravity: it shows +g while standing on the pad.
+  SPECIFIC_FORCE,
+  // A never negative magnitude, like the totalacc column of
+  // the simulation data. Without a sign it can't drive the
+  // prediction, so it only widens the process noise: the harder
+  // the rocket accelerates, the more the barometer is trusted.
+  // The bias state then follows the (negated) mean acceleration.
+  MAGNITUDE,
+};
+
+// Estimates altitude, vertical velocity and accelerometer bias from
+// barometric altitude and measured acceleration, with a constant
+// acceleration model. All matrices are fixed size, so nothing is
+// allocated.
+//
+// With a nominal period the constructor iterates the Riccati
+// equation to the steady-state gain once, in double. Samples at
+// that period are then just the prediction plus a constant gain
+// correction, a handful of multiply-adds that are cheap in float
+// on an MCU. The period varies a lot in practice though (1ms to
+// 500ms in the simulation data), so other samples, and those with
+// the process noise widened by a MAGNITUDE acceleration, propagate
+// the covariance and compute the gain online instead. Only the
+// altitude is measured, so neither needs a matrix inversion.
+template<typename Scalar=float>
+class AltitudeKalmanFilter
+{
+public:
+  using state_t = Eigen::Matrix<Scalar, 3, 1>;
+  using matrix_t = Eigen::Matrix<Scalar, 3, 3>;
+
+  static constexpr Scalar GRAVITY = Scalar(9.80665);
+  // How far dt may be off the nominal period, relative,
+  // and still use the steady-state gain
+  static constexpr Scalar PERIOD_TOLERANCE = Scalar(0.01);
+  static constexpr int GAIN_ITERATIONS = 100000;
+
+  struct parameters_t {
+    acceleration_frame frame;
+    // Standard deviation of unmodelled acceleration, m/s^2
+    Scalar acceleration_noise;
+    // Random walk of the accelerometer bias, m/s^2 per sqrt(s)
+    Scalar bias_noise;
+    // Standard deviation of the barometric altitude, m
+    Scalar altitude_noise;
+    // The nominal sample period in seconds, zero if there is
+    // none and the gain is always computed online
+    Scalar period = 0;
+  };
+
+  AltitudeKalmanFilter(const parameters_t& parameters)
+    : _parameters(parameters)
+  {
+    if(parameters.period > 0)
+    {
+      const auto m = model<double>(parameters.period, parameters.acceleration_noise);
+      const auto r = double(parameters.altitude_noise) * parameters.altitude_noise;
+      Eigen::Matrix3d covariance = initial_covariance().template cast<double>();
+      Eigen::Vector3d gain = Eigen::Vector3d::Zero();
+      for(int i=0; i < GAIN_ITERATIONS; ++i)
+      {
+        covariance = m.transition * covariance * m.transition.transpose() + m.noise;
+        const Eigen::Vector3d next = covariance.col(0) / (covariance(0, 0) + r);
+        covariance -= next * covariance.row(0);
+        const auto converged = (next - gain).cwiseAbs().maxCoeff() <= 1e-12 * next.cwiseAbs().maxCoeff();
+        gain = next;
+        if(converged)
+        {
+          break;
+        }
+      }
+      _steady.transition = m.transition.template cast<Scalar>();
+      _steady.control = m.control.template cast<Scalar>();
+      _steady.gain = gain.template cast<Scalar>();
+      _steady.covariance = covariance.template cast<Scalar>();
+    }
+    reset(0);
+  }
+
+  // Sets the initial state, e.g. zero altitude on the pad. The
+  // altitude starts out as certain as the barometer, velocity
+  // and bias as uncertain as the acceleration noise.
+  void reset(Scalar altitude, Scalar velocity=0, Scalar bias=0)
+  {
+    _state << altitude, velocity, bias;
+    _covariance = initial_covariance();
+    _gain = state_t::Zero();
+    _in_steady_state = false;
+  }
+
+  // Advances the state by dt seconds with the
+  // acceleration measured in the configured frame.
+  void predict(Scalar dt, Scalar acceleration)
+  {
+    auto noise_level = _parameters.acceleration_noise;
+    acceleration = vertical(acceleration, noise_level);
+    const auto m = model<Scalar>(dt, noise_level);
+    _state = m.transition * _state + m.control * acceleration;
+    _covariance = m.transition * _covariance * m.transition.transpose() + m.noise;
+    _in_steady_state = false;
+  }
+
+  // Corrects with the barometric altitude. With H = [1 0 0],
+  // H P H' is just P(0, 0) and P H' the first column.
+  void correct(Scalar altitude)
+  {
+    const auto r = _parameters.altitude_noise * _parameters.altitude_noise;
+    _gain = _covariance.col(0) / (_covariance(0, 0) + r);
+    _state += _gain * (altitude - _state(0));
+    _covariance -= _gain * _covariance.row(0);
+    // Keep rounding from making it asymmetric
+    const matrix_t symmetric = (_covariance + _covariance.transpose()) / 2;
+    _covariance = symmetric;
+  }
+
+  // Both steps for one sample, with the steady-state
+  // gain if the sample allows for it
+  const state_t& update(Scalar dt, Scalar altitude, Scalar acceleration)
+  {
+    auto noise_level = _parameters.acceleration_noise;
+    const auto input = vertical(acceleration, noise_level);
+    const auto period = _parameters.period;
+    if(period > 0 && noise_level == _parameters.acceleration_noise
+       && std::abs(dt - period) <= period * PERIOD_TOLERANCE)
+    {
+      _state = _steady.transition * _state + _steady.control * input;
+      _state += _steady.gain * (altitude - _state(0));
+      if(!_in_steady_state)
+      {
+        // So the online path can pick up from here
+        _gain = _steady.gain;
+        _covariance = _steady.covariance;
+        _in_steady_state = true;
+      }
+      return _state;
+    }
+    predict(dt, acceleration);
+    correct(altitude);
+    return _state;
+  }
+
+  Scalar altitude() const { return _state(0); }
+  Scalar velocity() const { return _state(1); }
+  Scalar bias() const { return _state(2); }
+
+  // Apogee is reached once the vertical velocity turns negative
+  bool descending() const { return _state(1) < 0; }
+
+  // The gain of the last correction
+  const state_t& gain() const { return _gain; }
+  const matrix_t& covariance() const { return _covariance; }
+  // The precomputed gain for the nominal period
+  const state_t& steady_state_gain() const { return _steady.gain; }
+
+private:
+  template<typename T>
+  struct model_t {
+    Eigen::Matrix<T, 3, 3> transition;
+    Eigen::Matrix<T, 3, 1> control;
+    Eigen::Matrix<T, 3, 3> noise;
+  };
+
+  template<typename T>
+  model_t<T> model(T dt, T noise_level) const
+  {
+    model_t<T> m;
+    m.transition << 1, dt, -dt * dt / 2,
+                    0, 1, -dt,
+                    0, 0, 1;
+    m.control << dt * dt / 2, dt, 0;
+    m.noise = m.control * m.control.transpose() * noise_level * noise_level;
+    m.noise(2, 2) = T(_parameters.bias_noise) * T(_parameters.bias_noise) * dt;
+    return m;
+  }
+
+  matrix_t initial_covariance() const
+  {
+    const auto a = _parameters.acceleration_noise;
+    matrix_t covariance = matrix_t::Zero();
+    covariance.diagonal() << _parameters.altitude_noise * _parameters.altitude_noise, a * a, a * a;
+    return covariance;
+  }
+
+  // The vertical acceleration driving the prediction, widening
+  // the noise level for a MAGNITUDE
+  Scalar vertical(Scalar acceleration, Scalar& noise_level) const
+  {
+    switch(_parameters.frame)
+    {
+    case acceleration_frame::VERTICAL:
+      break;
+    case acceleration_frame::SPECIFIC_FORCE:
+      return acceleration - GRAVITY;
+    case acceleration_frame::MAGNITUDE:
+      noise_level = std::max(noise_level, acceleration);
+      return 0;
+    }
+    return acceleration;
+  }
+
+  parameters_t _parameters;
+  struct {
+    matrix_t transition;
+    state_t control;
+    state_t gain = state_t::Zero();
+    matrix_t covariance;
+  } _steady;
+  bool _in_steady_state = false;
+  state_t _gain;
+  matrix_t _covariance;
+  state_t _state;
+};
+
+} // namespace far::junior
@@ -0,0 +1,170 @@
+#include "latency.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace far::junior;
+
+namespace {
+
+std::string write_csv(const char* name, const std::string& content)
+{
+  const auto path = (std::filesystem::temp_directory_path() / name).string();
+  std::ofstream(path) << content;
+  return path;
+}
+
+const detection_result_t& result_for(const std::vector<detection_result_t>& results, const char* event)
+{
+  return *std::find_if(results.begin(), results.end(),
+    [event](const detection_result_t& r) { return std::string(r.detection->event) == event; });
+}
+
+} // namespace
+
+TEST_CASE("Ground truth events", "[latency]")
+{
+  // The upper stage flies from the start, the lower
+  // stage file starts at separation.
+  const auto upper = write_csv("junior-latency-upper.csv",
+    "# Time (s),Total acceleration (m/s²),Air pressure (mbar)\n"
+    "# Event LAUNCH occurred at t=0 seconds\n"
+    "0.1,20,1000\n"
+    "0.2,20,999\n"
+    "# Event STAGE_SEPARATION occurred at t=0.25 seconds\n"
+    "0.3,5,998\n"
+    "# Event APOGEE occurred at t=0.35 seconds\n"
+    "0.4,1,998\n"
+    "0.5,1,998\n"
+    );
+  const auto lower = write_csv("junior-latency-lower.csv",
+    "0.3,1,998\n"
+    "# Event APOGEE occurred at t=0.32 seconds\n"
+    "0.4,1,999\n"
+    );
+  const auto tracks = load_stages(lower.c_str(), upper.c_str());
+  REQUIRE(tracks.size() == 2);
+
+  const auto names = [](const track_t& track)
+  {
+    std::vector<std::string> result;
+    for(const auto& e : track.events)
+    {
+      result.push_back(e.name);
+    }
+    return result;
+  };
+
+  SECTION("The second stage has all its own events")
+  {
+    REQUIRE(names(tracks[1]) == std::vector<std::string>{"LAUNCH", "STAGE_SEPARATION", "APOGEE"});
+  }
+
+  SECTION("The first stage shares the events up to separation")
+  {
+    REQUIRE(names(tracks[0]) == std::vector<std::string>{"LAUNCH", "STAGE_SEPARATION", "APOGEE"});
+    REQUIRE(tracks[0].events[2].time - tracks[0].events[0].time == 320ms);
+  }
+
+  SECTION("Events share the time base of the samples")
+  {
+    REQUIRE(tracks[1].samples.timestamps.front() - tracks[1].events[0].time == 100ms);
+  }
+}
+
+TEST_CASE("Detection latency", "[latency]")
+{
+  const auto start = timestamp_t{};
+  track_t track{"synthetic", {}, {
+      {"LAUNCH", start + 1s},
+      {"APOGEE", start + 7s},
+      {"GROUND_HIT", start + 20s},
+    }};
+  const std::vector<state_change_t> changes{
+    {start + 1500ms, state::LAUNCHED},
+    {start + 6500ms, state::FALLING_},
+    {start + 12s, state::DROUGE_OPENED},
+  };
+  const auto results = match(track, changes);
+  REQUIRE(results.size() == std::size(DETECTIONS));
+
+  SECTION("Timely detections have a positive latency")
+  {
+    const auto& launch = result_for(results, "LAUNCH");
+    REQUIRE(*launch.latency() == 500ms);
+    REQUIRE(!launch.early());
+  }
+
+  SECTION("Detections ahead of the event are early")
+  {
+    const auto& apogee = result_for(results, "APOGEE");
+    REQUIRE(*apogee.latency() == -500ms);
+    REQUIRE(apogee.early());
+  }
+
+  SECTION("Missing and unexpected detections")
+  {
+    REQUIRE(result_for(results, "GROUND_HIT").missed());
+    REQUIRE(result_for(results, "RECOVERY_DEVICE_DEPLOYMENT").unexpected());
+    const auto& burnout = result_for(results, "BURNOUT");
+    REQUIRE(!burnout.missed());
+    REQUIRE(!burnout.unexpected());
+  }
+
+  SECTION("The report aggregates over tracks")
+  {
+    latency_report_t report;
+    report.add(results);
+    const std::vector<state_change_t> later{
+      {start + 2500ms, state::LAUNCHED},
+    };
+    report.add(match(track, later));
+
+    const auto& launch = report.statistics[0];
+    REQUIRE(launch.count == 2);
+    REQUIRE(launch.min == 500ms);
+    REQUIRE(launch.max == 1500ms);
+    REQUIRE(launch.mean() == 1s);
+
+    const auto& apogee = report.statistics[2];
+    REQUIRE(apogee.count == 0);
+    REQUIRE(apogee.early == 1);
+    REQUIRE(apogee.missed == 1);
+    REQUIRE(report.statistics[4].missed == 2);
+    REQUIRE(report.statistics[3].unexpected == 1);
+  }
+}
+
+TEST_CASE("Simulation events", "[latency]")
+{
+  const auto start = timestamp_t{} + 3s;
+
+  SECTION("Event times are exact to the microsecond")
+  {
+    // Neither survives a round trip through float
+    const auto apogee = parse_event("# Event APOGEE occurred at t=12.925 seconds", start);
+    REQUIRE(apogee);
+    REQUIRE(apogee->name == "APOGEE");
+    REQUIRE(apogee->time - start == 12925ms);
+    REQUIRE(parse_event("# Event BURNOUT occurred at t=0.32 seconds", start)->time - start == 320ms);
+  }
+
+  SECTION("Other lines are no events")
+  {
+    REQUIRE(!parse_event("# Time (s),Total acceleration (m/s²),Air pressure (mbar)", start));
+    REQUIRE(!parse_event("0.01,8.803,995.658", start));
+  }
+
+  SECTION("Malformed events are skipped")
+  {
+    REQUIRE(!parse_event("# Event APOGEE", start));
+    REQUIRE(!parse_event("# Event APOGEE occurred at t= seconds", start));
+    REQUIRE(!parse_event("# Event APOGEE occurred at t=soon seconds", start));
+    REQUIRE(!parse_event("# Event APOGEE occurred at t=12.9s seconds", start));
+    REQUIRE(!parse_event("# Event APOGEE occurred at 12.925 seconds", start));
+  }
+}
@@ -0,0 +1,90 @@
+#include "latency.hpp"
+
+#include <algorithm>
+
+namespace far::junior {
+
+std::optional<duration_t> detection_result_t::latency() const
+{
+  if(truth && detected)
+  {
+    return *detected - *truth;
+  }
+  return std::nullopt;
+}
+
+bool detection_result_t::early() const
+{
+  return truth && detected && *detected < *truth;
+}
+
+bool detection_result_t::missed() const
+{
+  return truth && !detected;
+}
+
+bool detection_result_t::unexpected() const
+{
+  return !truth && detected;
+}
+
+std::vector<detection_result_t> match(const track_t& track, const std::vector<state_change_t>& changes)
+{
+  std::vector<detection_result_t> results;
+  for(const auto& detection : DETECTIONS)
+  {
+    detection_result_t result{&detection, std::nullopt, std::nullopt};
+    const auto truth = std::find_if(track.events.begin(), track.events.end(),
+      [&detection](const flight_event_t& e) { return e.name == detection.event; });
+    if(truth != track.events.end())
+    {
+      result.truth = truth->time;
+    }
+    const auto detected = std::find_if(changes.begin(), changes.end(),
+      [&detection](const state_change_t& c) { return c.to == detection.detected; });
+    if(detected != changes.end())
+    {
+      result.detected = detected->timestamp;
+    }
+    results.push_back(result);
+  }
+  return results;
+}
+
+void latency_statistics_t::add(const detection_result_t& result)
+{
+  if(result.early())
+  {
+    ++early;
+  }
+  else if(result.missed())
+  {
+    ++missed;
+  }
+  else if(result.unexpected())
+  {
+    ++unexpected;
+  }
+  else if(const auto latency = result.latency())
+  {
+    ++count;
+    min = std::min(min, *latency);
+    max = std::max(max, *latency);
+    total += *latency;
+  }
+}
+
+duration_t latency_statistics_t::mean() const
+{
+  return count ? total / int64_t(count) : duration_t::zero();
+}
+
+void latency_report_t::add(const std::vector<detection_result_t>& results)
+{
+  for(const auto& result : results)
+  {
+    statistics[size_t(result.detection - DETECTIONS)].add(result);
+  }
+}
+
+} // namespace far::junior
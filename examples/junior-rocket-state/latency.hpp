@@ -0,0 +1,68 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "simulator.hpp"
+
+#include <array>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+namespace far::junior {
+
+// Which state is supposed to detect which simulation event
+struct detection_t {
+  const char* event;
+  state detected;
+};
+
+constexpr detection_t DETECTIONS[] = {
+  {"LAUNCH", state::LAUNCHED},
+  {"BURNOUT", state::BURNOUT},
+  {"APOGEE", state::FALLING_},
+  {"RECOVERY_DEVICE_DEPLOYMENT", state::DROUGE_OPENED},
+  {"GROUND_HIT", state::LANDED},
+};
+
+// One of the DETECTIONS on a track. Only the first
+// occurrence of the event and the state count.
+struct detection_result_t {
+  const detection_t* detection;
+  std::optional<timestamp_t> truth;
+  std::optional<timestamp_t> detected;
+
+  // Negative if detected before it happened
+  std::optional<duration_t> latency() const;
+  bool early() const;
+  bool missed() const;
+  // Detected, but never happened
+  bool unexpected() const;
+};
+
+// One result per entry of DETECTIONS
+std::vector<detection_result_t> match(const track_t& track, const std::vector<state_change_t>& changes);
+
+// Latencies of one detection over several tracks. Only the
+// timely ones go into the latency figures.
+struct latency_statistics_t {
+  size_t count = 0;
+  duration_t min = duration_t::max();
+  duration_t max = duration_t::min();
+  duration_t total = duration_t::zero();
+  int early = 0;
+  int missed = 0;
+  int unexpected = 0;
+
+  void add(const detection_result_t& result);
+  duration_t mean() const;
+};
+
+// Statistics per entry of DETECTIONS
+struct latency_report_t {
+  std::array<latency_statistics_t, std::size(DETECTIONS)> statistics;
+
+  void add(const std::vector<detection_result_t>& results);
+};
+
+} // namespace far::junior
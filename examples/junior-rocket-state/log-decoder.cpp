@@ -0,0 +1,49 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+
+// Renders the binary log written by "junior-rocket-state logged-csv"
+// to text. The records are raw structs, so decode on the same kind
+// of host that wrote them.
+#include "log.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+
+using namespace far::junior;
+
+int main(int argc, char *argv[])
+{
+  if(argc != 2)
+  {
+    std::cerr << "usage: junior-log-decode <logfile>\n";
+    return 1;
+  }
+  std::ifstream file(argv[1], std::ios::binary);
+  if(!file)
+  {
+    std::cerr << "Can't open " << argv[1] << "\n";
+    return 1;
+  }
+  Log::record_type record;
+  std::optional<uint32_t> expected;
+  while(file.read(reinterpret_cast<char*>(&record), sizeof(record)))
+  {
+    if(expected && record.sequence != *expected)
+    {
+      std::cout << "... " << (record.sequence - *expected) << " records dropped\n";
+    }
+    expected = record.sequence + 1;
+    std::cout << record.sequence << " [" << deets::log::level_name(record.severity) << "] ";
+    if(record.message < std::size(MESSAGE_FORMATS))
+    {
+      std::cout << deets::log::render(record, MESSAGE_FORMATS[record.message]) << "\n";
+    }
+    else
+    {
+      std::cout << "unknown message " << record.message << "\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,39 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "binary-log.hpp"
+
+// The minimum level that is compiled in, e.g. DEBUG. Defaults
+// to no logging at all, as the flight computer can't spare
+// the cycles.
+#ifndef JUNIOR_LOG_LEVEL
+#define JUNIOR_LOG_LEVEL OFF
+#endif
+
+namespace far::junior {
+
+enum class message : uint16_t
+{
+  PRESSURE_STATS,
+  PEAK_PRESSURE_MEDIAN,
+  PEAK_PRESSURE,
+  PRESSURE_DROP_FIT,
+};
+
+// Indexed by message, only needed by the decoder
+constexpr const char* MESSAGE_FORMATS[] = {
+  "pressure stats: {}, {}",
+  "median: {}",
+  "peak pressure: {}",
+  "pressure drop fit: slope {}, curvature {}, F {}",
+};
+
+constexpr auto LOG_LEVEL = deets::log::level::JUNIOR_LOG_LEVEL;
+constexpr size_t LOG_CAPACITY = 1024;
+
+// An empty type when the level is OFF, the
+// ring only exists with logging compiled in
+using Log = deets::log::BinaryLog<message, LOG_LEVEL, LOG_CAPACITY>;
+
+} // namespace far::junior
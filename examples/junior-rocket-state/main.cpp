@@ -1,7 +1,18 @@
-#include "junior-rocket-state.hpp"
+#include "junior-rocket-state-impl.hpp"
 #include "simulator.hpp"
+#include "preprocessing.hpp"
+#include "histogram.hpp"
+#include "log.hpp"
+#include "flight-recorder.hpp"
+#include "sweep.hpp"
+#include "latency.hpp"
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
 
 using namespace far::junior;
 
@@ -40,6 +51,270 @@ class PrintObserver : public StateObserver
 
 };
 
+// Only listens to state changes, through static dispatch,
+// so the other hooks cost nothing while timing.
+class TransitionCounter
+{
+public:
+  void state_changed(timestamp_t, state)
+  {
+    ++transitions;
+  }
+
+  size_t transitions = 0;
+};
+
+// Prints everything and gives the detector a log to write to
+class LoggingPrintObserver : public PrintObserver
+{
+public:
+  Log* log() override
+  {
+    return &_log;
+  }
+
+private:
+  Log _log;
+};
+
+// Drains the detector log into a file after every sample,
+// so the ring never overflows during a replay. Decode it
+// with junior-log-decode.
+template<typename Driver>
+class LogWriter
+{
+public:
+  LogWriter(Driver& driver, Log& log, const char* filename)
+    : _driver(driver)
+    , _log(log)
+    , _file(filename, std::ios::binary)
+  {}
+
+  void drive(timestamp_t timestamp, float pressure, float acceleration)
+  {
+    _driver.drive(timestamp, pressure, acceleration);
+    _log.drain([this](const Log::record_type& record)
+    {
+      _file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    });
+  }
+
+private:
+  Driver& _driver;
+  Log& _log;
+  std::ofstream _file;
+};
+
+using histogram_t = deets::statistics::Histogram<>;
+
+void print_histogram(const char* name, const histogram_t& histogram)
+{
+  std::cout << name << " (ns, " << histogram.total() << " samples): "
+            << "min " << histogram.min()
+            << ", mean " << histogram.mean()
+            << ", p50 " << histogram.percentile(50)
+            << ", p90 " << histogram.percentile(90)
+            << ", p99 " << histogram.percentile(99)
+            << ", p99.9 " << histogram.percentile(99.9)
+            << ", max " << histogram.max() << "\n";
+}
+
+// Replays the flight and records how long each drive() takes,
+// and separately those that lead to a state transition.
+void timing(const char* first_stage_filename, const char* second_stage_filename, int replays)
+{
+  const auto data = load_first_stage(first_stage_filename, second_stage_filename);
+  histogram_t drive_time, transition_time;
+  for(auto replay=0; replay < replays; ++replay)
+  {
+    TransitionCounter counter;
+    BasicJuniorRocketState<TransitionCounter> state_machine(counter);
+    for(const auto& entry : data)
+    {
+      const auto transitions = counter.transitions;
+      const auto start = std::chrono::steady_clock::now();
+      state_machine.drive(entry.time, entry.pressure, entry.totalacc);
+      const uint64_t elapsed = (std::chrono::steady_clock::now() - start) / 1ns;
+      drive_time.record(elapsed);
+      if(counter.transitions != transitions)
+      {
+        transition_time.record(elapsed);
+      }
+    }
+  }
+  print_histogram("drive", drive_time);
+  print_histogram("sample to transition", transition_time);
+
+  // Whole replays without the clock in the loop,
+  // sample by sample and as one block.
+  const auto log = to_sample_log(data);
+  std::vector<state_change_t> changes(data.size());
+  const auto per_sample_start = std::chrono::steady_clock::now();
+  for(auto replay=0; replay < replays; ++replay)
+  {
+    TransitionCounter counter;
+    BasicJuniorRocketState<TransitionCounter> state_machine(counter);
+    drive(data, state_machine);
+  }
+  const auto block_start = std::chrono::steady_clock::now();
+  for(auto replay=0; replay < replays; ++replay)
+  {
+    TransitionCounter counter;
+    BasicJuniorRocketState<TransitionCounter> state_machine(counter);
+    state_machine.drive(log.block(), changes.data());
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const auto samples = double(data.size()) * replays;
+  std::cout << "replay (ns/sample): per sample " << (block_start - per_sample_start) / 1ns / samples
+            << ", block " << (end - block_start) / 1ns / samples << "\n";
+}
+
+// Runs a detector per stage, and prints the merged timeline
+void stages(const char* first_stage_filename, const char* second_stage_filename)
+{
+  const auto tracks = load_stages(first_stage_filename, second_stage_filename);
+  const auto start = std::chrono::steady_clock::now();
+  const auto timeline = run_tracks(tracks);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto origin = tracks[0].samples.timestamps.front();
+  for(const auto& entry : timeline)
+  {
+    std::cout << (entry.change.timestamp - origin) / 1us << ", "
+              << tracks[entry.track].name << " -> " << entry.change.to << "\n";
+  }
+  std::cerr << "Ran " << tracks.size() << " stages in " << elapsed / 1us << "us\n";
+}
+
+void print_parameters(const detector_parameters_t& p)
+{
+  std::cout << "  launch acceleration " << p.launch_acceleration_threshold
+            << ", freefall acceleration " << p.freefall_acceleration_threshold
+            << ", launch pressure " << p.launch_pressure_differential
+            << ", peak margin " << p.peak_pressure_margin << "\n"
+            << "  apogee time " << p.apogee_time / 1ms << "ms + " << p.apogee_detection_margin / 1ms << "ms"
+            << ", ground variance " << p.pressure_variance_threshold
+            << ", drop significance " << p.pressure_drop_significance
+            << ", drop curvature " << p.pressure_drop_curvature << "\n"
+            << "  timeouts: acceleration " << p.acceleration_timeout / 1ms
+            << "ms, separation " << p.separation_timeout / 1ms
+            << "ms, burn " << p.motor_burntime / 1ms
+            << "ms, falling " << p.falling_pressure_timeout / 1ms << "ms\n";
+}
+
+void print_score(const score_t& score)
+{
+  std::cout << score.false_triggers << " false, " << score.missed << " missed, "
+            << score.latency / 1ms << "ms latency\n";
+}
+
+// Random search over the detector parameters on all given flights,
+// prints the best configurations and where the defaults rank.
+void run_sweep(int count, const std::vector<std::pair<const char*, const char*>>& flights)
+{
+  std::vector<track_t> tracks;
+  for(const auto& [first_stage_filename, second_stage_filename] : flights)
+  {
+    for(auto& track : load_stages(first_stage_filename, second_stage_filename))
+    {
+      tracks.push_back(std::move(track));
+    }
+  }
+  std::mt19937 generator(count);
+  // The defaults are the first configuration
+  std::vector<detector_parameters_t> configurations(1);
+  for(int i=1; i < count; ++i)
+  {
+    configurations.push_back(random_parameters(generator));
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto results = sweep(tracks, configurations);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  for(size_t rank=0; rank < std::min<size_t>(results.size(), 5); ++rank)
+  {
+    std::cout << "#" << rank + 1 << ": ";
+    print_score(results[rank].score);
+    print_parameters(results[rank].parameters);
+  }
+  const auto baseline = std::find_if(results.begin(), results.end(),
+    [](const sweep_result_t& r) { return r.configuration == 0; });
+  std::cout << "defaults rank #" << (baseline - results.begin()) + 1 << ": ";
+  print_score(baseline->score);
+  std::cerr << "Scored " << configurations.size() << " configurations on " << tracks.size()
+            << " tracks in " << elapsed / 1ms << "ms\n";
+}
+
+void print_latency_statistics(const latency_report_t& report)
+{
+  for(size_t i=0; i < report.statistics.size(); ++i)
+  {
+    const auto& stats = report.statistics[i];
+    std::cout << "  " << DETECTIONS[i].event << ": ";
+    if(stats.count)
+    {
+      std::cout << stats.count << " detected, min " << stats.min / 1ms
+                << "ms, mean " << stats.mean() / 1ms << "ms, max " << stats.max / 1ms << "ms";
+    }
+    else
+    {
+      std::cout << "none detected in time";
+    }
+    std::cout << ", " << stats.early << " early, " << stats.missed << " missed, "
+              << stats.unexpected << " unexpected\n";
+  }
+}
+
+// Detection latency against the events of the simulation, per
+// track, per flight and over all flights.
+void latency(const std::vector<std::pair<const char*, const char*>>& flights)
+{
+  latency_report_t total;
+  for(const auto& [first_stage_filename, second_stage_filename] : flights)
+  {
+    latency_report_t flight;
+    for(const auto& track : load_stages(first_stage_filename, second_stage_filename))
+    {
+      // Times are relative to the launch, as in the simulation
+      const auto launch = std::find_if(track.events.begin(), track.events.end(),
+        [](const flight_event_t& e) { return e.name == "LAUNCH"; });
+      const auto origin = launch != track.events.end() ? launch->time : track.samples.timestamps.front();
+      const auto results = match(track, detect(track.samples));
+      std::cout << first_stage_filename << ", " << track.name << "\n";
+      for(const auto& result : results)
+      {
+        std::cout << "  " << result.detection->event << " -> " << result.detection->detected << ": ";
+        if(result.truth)
+        {
+          std::cout << "at " << (*result.truth - origin) / 1ms << "ms, ";
+        }
+        if(const auto latency = result.latency())
+        {
+          std::cout << "latency " << *latency / 1ms << "ms" << (result.early() ? " (early)" : "") << "\n";
+        }
+        else if(result.missed())
+        {
+          std::cout << "missed\n";
+        }
+        else if(result.unexpected())
+        {
+          std::cout << "detected at " << (*result.detected - origin) / 1ms << "ms without the event\n";
+        }
+        else
+        {
+          std::cout << "correctly not detected\n";
+        }
+      }
+      flight.add(results);
+      total.add(results);
+    }
+    std::cout << first_stage_filename << ", both stages\n";
+    print_latency_statistics(flight);
+  }
+  std::cout << "All flights\n";
+  print_latency_statistics(total);
+}
+
 // [](state from, state to, uint32_t timestamp) {
 //   const float at = float(timestamp) / 1000 * 1000;
 //
@@ -60,6 +335,79 @@ int main(int argc, char *argv[])
     JuniorRocketState state_machine(printer);
     load_and_drive(argv[2], argv[3], state_machine);
   }
+  else if(argc == 5 && std::string(argv[1]) == "logged-csv")
+  {
+    LoggingPrintObserver printer;
+    JuniorRocketState state_machine(printer);
+    LogWriter<JuniorRocketState> writer(state_machine, *printer.log(), argv[4]);
+    drive(load_first_stage(argv[2], argv[3]), writer);
+  }
+  else if(argc == 4 && std::string(argv[1]) == "despiked-csv")
+  {
+    PrintObserver printer;
+    JuniorRocketState state_machine(printer);
+    Preprocessor<PressureDespiker> despiked(
+      state_machine,
+      PressureDespiker{PRESSURE_DESPIKE_THRESHOLD, PRESSURE_DESPIKE_MIN_DEVIATION}
+      );
+    drive(load_first_stage(argv[2], argv[3]), despiked);
+    std::cerr << "Replaced " << despiked.pressure_filter().replaced() << " pressure samples\n";
+  }
+  else if(argc == 4 && std::string(argv[1]) == "filtered-csv")
+  {
+    PrintObserver printer;
+    JuniorRocketState state_machine(printer);
+    Preprocessor<PressureDespiker, AccelerationLowpass> filtered(
+      state_machine,
+      PressureDespiker{PRESSURE_DESPIKE_THRESHOLD, PRESSURE_DESPIKE_MIN_DEVIATION},
+      AccelerationLowpass{ACCELERATION_LOWPASS}
+      );
+    drive(load_first_stage(argv[2], argv[3]), filtered);
+  }
+  else if(argc == 5 && std::string(argv[1]) == "record")
+  {
+    std::ofstream file(argv[4], std::ios::binary);
+    FlightRecorder recorder([&file](const uint8_t* page, size_t size)
+    {
+      file.write(reinterpret_cast<const char*>(page), std::streamsize(size));
+    });
+    JuniorRocketState state_machine(recorder);
+    load_and_drive(argv[2], argv[3], state_machine);
+    recorder.flush();
+    std::cerr << "Wrote " << recorder.pages_written() << " pages\n";
+  }
+  else if(argc == 3 && std::string(argv[1]) == "replay-log")
+  {
+    PrintObserver printer;
+    JuniorRocketState state_machine(printer);
+    drive(load_flight_log(argv[2]), state_machine);
+  }
+  else if(argc >= 4 && argc % 2 == 0 && std::string(argv[1]) == "latency")
+  {
+    std::vector<std::pair<const char*, const char*>> flights;
+    for(int i=2; i < argc; i += 2)
+    {
+      flights.emplace_back(argv[i], argv[i + 1]);
+    }
+    latency(flights);
+  }
+  else if(argc >= 5 && argc % 2 == 1 && std::string(argv[1]) == "sweep")
+  {
+    std::vector<std::pair<const char*, const char*>> flights;
+    for(int i=3; i < argc; i += 2)
+    {
+      flights.emplace_back(argv[i], argv[i + 1]);
+    }
+    run_sweep(std::stoi(argv[2]), flights);
+  }
+  else if(argc == 4 && std::string(argv[1]) == "stages")
+  {
+    stages(argv[2], argv[3]);
+  }
+  else if((argc == 4 || argc == 5) && std::string(argv[1]) == "timing")
+  {
+    timing(argv[2], argv[3], argc == 5 ? std::stoi(argv[4]) : 100);
+  }
   else
   {
     std::cerr << "Unknown command\r\n";
@@ -0,0 +1,119 @@
+#include "junior-rocket-state-impl.hpp"
+#include "synthetic-flight.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace far::junior;
+
+namespace {
+
+struct TransitionRecorder
+{
+  void state_changed(timestamp_t, state to)
+  {
+    states.push_back(to);
+  }
+
+  std::vector<state> states;
+};
+
+struct EventCounter
+{
+  void event_produced(timestamp_t, event)
+  {
+    ++events;
+  }
+
+  size_t events = 0;
+};
+
+struct VirtualRecorder : StateObserver
+{
+  void state_changed(timestamp_t, state to) override
+  {
+    states.push_back(to);
+  }
+
+  void event_produced(timestamp_t, event) override
+  {
+    ++events;
+  }
+
+  std::vector<state> states;
+  size_t events = 0;
+};
+
+struct LoggingObserver
+{
+  Log* log()
+  {
+    return &records;
+  }
+
+  Log records;
+};
+
+// A launch on the pad, the first five seconds of the synthetic flight
+template<typename Driver>
+void launch(Driver& driver)
+{
+  synthetic_flight_t flight;
+  flight.samples = 100;
+  drive(synthetic_flight(flight), driver);
+}
+
+} // namespace
+
+static_assert(hooks::has_state_changed<TransitionRecorder>::value);
+static_assert(!hooks::has_data<TransitionRecorder>::value);
+static_assert(!hooks::has_elapsed<EventCounter>::value);
+static_assert(hooks::has_data<StateObserver>::value);
+static_assert(hooks::has_log<StateObserver>::value);
+static_assert(!hooks::has_log<TransitionRecorder>::value);
+
+TEST_CASE("Static observers", "[observer]")
+{
+  VirtualRecorder reference;
+  JuniorRocketState reference_state(reference);
+  launch(reference_state);
+  REQUIRE(std::find(reference.states.begin(), reference.states.end(), state::LAUNCHED) != reference.states.end());
+
+  SECTION("A single observer only sees the hooks it has")
+  {
+    TransitionRecorder recorder;
+    BasicJuniorRocketState<TransitionRecorder> rocket(recorder);
+    launch(rocket);
+    REQUIRE(recorder.states == reference.states);
+  }
+
+  SECTION("Several observers listen at once")
+  {
+    TransitionRecorder recorder;
+    EventCounter counter;
+    ObserverSet observers{recorder, counter, reference};
+    BasicJuniorRocketState<decltype(observers)> rocket(observers);
+    const auto expected_states = reference.states;
+    const auto expected_events = reference.events;
+    launch(rocket);
+    REQUIRE(recorder.states == expected_states);
+    REQUIRE(counter.events == expected_events);
+    // The virtual adapter works as one of them
+    REQUIRE(reference.events == 2 * expected_events);
+  }
+
+  SECTION("Only an observer with a log gets the detector log")
+  {
+    TransitionRecorder recorder;
+    LoggingObserver logging;
+    ObserverSet observers{recorder, logging};
+    BasicJuniorRocketState<decltype(observers)> rocket(observers);
+    launch(rocket);
+    REQUIRE(logging.records.size() > 0);
+    Log::record_type record;
+    REQUIRE(logging.records.pop(record));
+    REQUIRE(record.message == uint16_t(message::PRESSURE_STATS));
+  }
+}
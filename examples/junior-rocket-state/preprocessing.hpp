@@ -0,0 +1,94 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "junior-rocket-state.hpp"
+#include "filters.hpp"
+
+namespace far::junior {
+
+// Window and limits of the barometer de-spiking. The minimal
+// deviation keeps the filter from clamping the slow changes
+// on the pad, where the MAD is zero.
+constexpr int PRESSURE_DESPIKE_WINDOW = 7;
+constexpr float PRESSURE_DESPIKE_THRESHOLD = 3.0;
+constexpr float PRESSURE_DESPIKE_MIN_DEVIATION = .5;
+
+using PressureDespiker = deets::filters::HampelFilter<float, PRESSURE_DESPIKE_WINDOW>;
+
+// The nominal sensor rate, and a cutoff that keeps the motor
+// thrust profile but removes the oscillation of the raw
+// acceleration that makes the launch threshold flap.
+constexpr double ACCELERATION_SAMPLE_RATE = 20.0;
+constexpr double ACCELERATION_LOWPASS_CUTOFF = 4.0;
+constexpr int ACCELERATION_LOWPASS_SECTIONS = 1;
+
+using AccelerationLowpass = deets::filters::BiquadCascade<float, ACCELERATION_LOWPASS_SECTIONS>;
+constexpr auto ACCELERATION_LOWPASS = deets::filters::butterworth_lowpass<float, ACCELERATION_LOWPASS_SECTIONS>(
+  ACCELERATION_LOWPASS_CUTOFF, ACCELERATION_SAMPLE_RATE
+  );
+
+// A pipeline stage in front of JuniorRocketState::drive,
+// filtering pressure and acceleration individually.
+template<typename PressureFilter, typename AccelerationFilter=deets::filters::Passthrough<float>>
+class Preprocessor
+{
+public:
+  Preprocessor(JuniorRocketState& state, PressureFilter pressure_filter={}, AccelerationFilter acceleration_filter={})
+    : _state(state)
+    , _pressure_filter(pressure_filter)
+    , _acceleration_filter(acceleration_filter)
+  {}
+
+  void drive(timestamp_t timestamp, float pressure, float acceleration)
+  {
+    _state.drive(
+      timestamp,
+      _pressure_filter.filter(pressure),
+      _acceleration_filter.filter(acceleration)
+      );
+  }
+
+  const PressureFilter& pressure_filter() const { return _pressure_filter; }
+  const AccelerationFilter& acceleration_filter() const { return _acceleration_filter; }
+
+private:
+  JuniorRocketState& _state;
+  PressureFilter _pressure_filter;
+  AccelerationFilter _acceleration_filter;
+};
+
+// Brings a high rate sensor stream down to the rate the state
+// machine needs: only every Factor-th sample is driven, after
+// anti-alias filtering. The samples driven lag their timestamp
+// by GROUP_DELAY input samples.
+template<int Factor, int TapsPerPhase=16>
+class DecimatingPreprocessor
+{
+public:
+  using decimator_t = deets::filters::Decimator<float, Factor, TapsPerPhase>;
+  static constexpr double GROUP_DELAY = decimator_t::GROUP_DELAY;
+
+  DecimatingPreprocessor(JuniorRocketState& state)
+    : _state(state)
+  {}
+
+  void drive(timestamp_t timestamp, float pressure, float acceleration)
+  {
+    float decimated_pressure, decimated_acceleration;
+    // Both decimators run in lockstep
+    const auto produced = _pressure.update(pressure, &decimated_pressure) != &decimated_pressure;
+    _acceleration.update(acceleration, &decimated_acceleration);
+    if(produced)
+    {
+      _state.drive(timestamp, decimated_pressure, decimated_acceleration);
+    }
+  }
+
+private:
+  JuniorRocketState& _state;
+  decimator_t _pressure;
+  decimator_t _acceleration;
+};
+
+} // namespace far::junior
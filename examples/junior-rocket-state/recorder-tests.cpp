@@ -0,0 +1,174 @@
+#include "junior-rocket-state-impl.hpp"
+#include "flight-recorder.hpp"
+#include "synthetic-flight.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace far::junior;
+
+namespace {
+
+struct PageSink
+{
+  void operator()(const uint8_t* page, size_t size)
+  {
+    sizes.push_back(size);
+    data->insert(data->end(), page, page + size);
+  }
+
+  std::vector<uint8_t>* data;
+  std::vector<size_t> sizes = {};
+};
+
+struct Collector
+{
+  void sample(uint64_t us, float pressure, float acceleration)
+  {
+    samples.push_back({timestamp_t{} + us * 1us, acceleration, pressure});
+  }
+
+  void state(uint64_t us, far::junior::state s)
+  {
+    states.push_back({timestamp_t{} + us * 1us, s});
+  }
+
+  void event(uint64_t, far::junior::event e)
+  {
+    events.push_back(e);
+  }
+
+  std::vector<data_row_t> samples;
+  std::vector<state_change_t> states;
+  std::vector<far::junior::event> events;
+};
+
+struct ChangeRecorder
+{
+  void state_changed(timestamp_t timestamp, state to)
+  {
+    changes.push_back({timestamp, to});
+  }
+
+  std::vector<state_change_t> changes;
+};
+
+} // namespace
+
+TEST_CASE("Flight recorder", "[recorder]")
+{
+  using namespace flight_log;
+  const auto data = synthetic_flight();
+
+  std::vector<uint8_t> log;
+  PageSink sink{&log};
+  FlightRecorder<PageSink&, 128> recorder(sink);
+  JuniorRocketState detector(recorder);
+  drive(data, detector);
+  recorder.flush();
+
+  ChangeRecorder reference;
+  BasicJuniorRocketState<ChangeRecorder> reference_detector(reference);
+  drive(data, reference_detector);
+  REQUIRE(reference.changes.size() > 5);
+
+  SECTION("Only whole pages reach the sink")
+  {
+    REQUIRE(recorder.pages_written() > 1);
+    REQUIRE(log.size() == recorder.pages_written() * 128);
+    REQUIRE(std::all_of(sink.sizes.begin(), sink.sizes.end(), [](size_t size) { return size == 128; }));
+  }
+
+  SECTION("The deltas pack a sample into a few bytes")
+  {
+    std::vector<uint8_t> samples_only;
+    FlightRecorder<PageSink, 128> sample_recorder(PageSink{&samples_only});
+    for(const auto& row : data)
+    {
+      sample_recorder.data(row.time, row.pressure, row.totalacc);
+    }
+    sample_recorder.flush();
+    // Instead of 16 bytes for timestamp and two floats
+    REQUIRE(samples_only.size() < data.size() * 8);
+  }
+
+  SECTION("Samples round trip at the recording resolution")
+  {
+    Collector collector;
+    const auto result = decode<128>(log.data(), log.size(), collector);
+    REQUIRE(result.blocks == recorder.pages_written());
+    REQUIRE(result.corrupt_blocks == 0);
+    REQUIRE(collector.samples.size() == data.size());
+    for(size_t i=0; i < data.size(); ++i)
+    {
+      REQUIRE(collector.samples[i].time == data[i].time);
+      REQUIRE(collector.samples[i].pressure == Catch::Approx(data[i].pressure).margin(0.0006));
+      REQUIRE(collector.samples[i].totalacc == Catch::Approx(data[i].totalacc).margin(0.0006));
+    }
+    REQUIRE(collector.states == reference.changes);
+  }
+
+  SECTION("Replaying the log reproduces the state changes")
+  {
+    Collector collector;
+    decode<128>(log.data(), log.size(), collector);
+    ChangeRecorder replayed;
+    BasicJuniorRocketState<ChangeRecorder> replay_detector(replayed);
+    drive(collector.samples, replay_detector);
+    REQUIRE(replayed.changes == reference.changes);
+  }
+
+  SECTION("A corrupt page is skipped, the others still decode")
+  {
+    Collector complete;
+    decode<128>(log.data(), log.size(), complete);
+
+    log[128 + HEADER_SIZE + 3] ^= 0x10;
+    Collector collector;
+    const auto result = decode<128>(log.data(), log.size(), collector);
+    REQUIRE(result.corrupt_blocks == 1);
+    REQUIRE(collector.samples.size() < complete.samples.size());
+    REQUIRE(collector.samples.front().time == complete.samples.front().time);
+    REQUIRE(collector.samples.back().time == complete.samples.back().time);
+  }
+}
+
+TEST_CASE("Flight log encoding", "[recorder]")
+{
+  using namespace flight_log;
+
+  SECTION("Zig-zag keeps small magnitudes small")
+  {
+    REQUIRE(zigzag(0) == 0);
+    REQUIRE(zigzag(-1) == 1);
+    REQUIRE(zigzag(1) == 2);
+    for(int32_t value : {0, 1, -1, 1000, -1000, INT32_MAX, INT32_MIN})
+    {
+      REQUIRE(unzigzag(zigzag(value)) == value);
+    }
+  }
+
+  SECTION("Varints round trip and detect truncation")
+  {
+    uint8_t buffer[10];
+    for(uint64_t value : {uint64_t(0), uint64_t(127), uint64_t(128), uint64_t(1) << 40, ~uint64_t(0)})
+    {
+      const auto end = put_varint(buffer, value);
+      uint64_t decoded = 0;
+      REQUIRE(get_varint(buffer, end, decoded) == end);
+      REQUIRE(decoded == value);
+    }
+    const auto end = put_varint(buffer, 300);
+    uint64_t decoded;
+    REQUIRE(get_varint(buffer, end - 1, decoded) == nullptr);
+  }
+
+  SECTION("The CRC matches the standard check value")
+  {
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    REQUIRE(crc32(check, sizeof(check)) == 0xCBF43926u);
+  }
+}
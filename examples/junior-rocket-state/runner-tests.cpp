@@ -0,0 +1,75 @@
+#include "synthetic-flight.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace far::junior;
+
+namespace {
+
+// Calm on the pad, then a launch at the given time,
+// climbing for 5s and staying up there
+sample_log_t flight(float launch_time)
+{
+  synthetic_flight_t flight;
+  flight.samples = 300;
+  flight.launch_time = launch_time;
+  flight.climb_time = 5.0f;
+  flight.descent_rate = 0.0f;
+  return to_sample_log(synthetic_flight(flight));
+}
+
+} // namespace
+
+TEST_CASE("Multi-stage runner", "[runner]")
+{
+  const std::vector<track_t> tracks{
+    {"early", flight(1.0f), {}},
+    {"late", flight(4.0f), {}},
+  };
+  const auto timeline = run_tracks(tracks);
+
+  SECTION("The timeline is ordered by time")
+  {
+    REQUIRE(std::is_sorted(timeline.begin(), timeline.end(),
+      [](const timeline_entry_t& a, const timeline_entry_t& b)
+      {
+        return a.change.timestamp < b.change.timestamp;
+      }));
+  }
+
+  SECTION("Each track matches driving it on its own")
+  {
+    for(size_t track=0; track < tracks.size(); ++track)
+    {
+      StateObserver nop;
+      JuniorRocketState detector(nop);
+      const auto expected = drive_block(tracks[track].samples, detector);
+      std::vector<state_change_t> changes;
+      for(const auto& entry : timeline)
+      {
+        if(entry.track == track)
+        {
+          changes.push_back(entry.change);
+        }
+      }
+      REQUIRE(changes == expected);
+    }
+  }
+
+  SECTION("Tracks launch independently")
+  {
+    const auto launched = [&timeline](size_t track)
+    {
+      const auto it = std::find_if(timeline.begin(), timeline.end(), [track](const timeline_entry_t& entry)
+      {
+        return entry.track == track && entry.change.to == state::LAUNCHED;
+      });
+      REQUIRE(it != timeline.end());
+      return it->change.timestamp;
+    };
+    REQUIRE(launched(0) < launched(1));
+  }
+}
@@ -0,0 +1,74 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "junior-rocket-state.hpp"
+#include "spsc-ring.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace far::junior {
+
+struct sample_t {
+  timestamp_t timestamp;
+  float pressure;
+  float acceleration;
+};
+
+// Hands samples from the sensor interrupt or DMA callback to the
+// main loop. The interrupt push()es, the main loop calls drive()
+// with its detector, which pops up to Batch samples at a time into
+// SoA buffers for the block drive.
+template<size_t Capacity, size_t Batch=32>
+class SampleQueue
+{
+public:
+  // Interrupt side, false if the sample had to be dropped
+  bool push(timestamp_t timestamp, float pressure, float acceleration)
+  {
+    return _ring.push(sample_t{timestamp, pressure, acceleration});
+  }
+
+  // Main loop side. Drives the pending samples, but no more than
+  // Capacity, so an interrupt that keeps pushing can't hold the
+  // main loop here. Writes the state changes to changes, which
+  // needs room for Capacity entries, and returns their number.
+  template<typename Detector>
+  size_t drive(Detector& detector, state_change_t* changes)
+  {
+    size_t count = 0;
+    for(size_t taken=0; taken < Capacity;)
+    {
+      const auto popped = _ring.pop(_batch.data(), std::min(Batch, Capacity - taken));
+      if(!popped)
+      {
+        break;
+      }
+      for(size_t i=0; i < popped; ++i)
+      {
+        _timestamps[i] = _batch[i].timestamp;
+        _pressures[i] = _batch[i].pressure;
+        _accelerations[i] = _batch[i].acceleration;
+      }
+      count += detector.drive(
+        sample_block_t{_timestamps.data(), _pressures.data(), _accelerations.data(), popped},
+        changes + count
+        );
+      taken += popped;
+    }
+    return count;
+  }
+
+  uint32_t overruns() const { return _ring.overruns(); }
+  size_t high_water_mark() const { return _ring.high_water_mark(); }
+
+private:
+  deets::concurrent::SpscRing<sample_t, Capacity> _ring;
+  std::array<sample_t, Batch> _batch;
+  std::array<timestamp_t, Batch> _timestamps;
+  std::array<float, Batch> _pressures;
+  std::array<float, Batch> _accelerations;
+};
+
+} // namespace far::junior
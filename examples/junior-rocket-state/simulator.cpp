@@ -1,26 +1,34 @@
 #include "simulator.hpp"
+#include "junior-rocket-state-impl.hpp"
+#include "flight-recorder.hpp"
 
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <iterator>
 #include <sstream>
 #include <locale>
 #include <chrono>
+#include <cassert>
+#include <algorithm>
+#include <thread>
+#include <utility>
 
 namespace far::junior {
 
 using namespace std::chrono_literals;
 
-struct data_row_t {
-  timestamp_t time;
-  float totalacc;
-  float pressure;
-
-};
-
 namespace {
 using namespace std::chrono_literals;
 
+constexpr char EVENT_PREFIX[] = "# Event ";
+
+struct stage_data_t {
+  std::vector<data_row_t> rows;
+  std::vector<flight_event_t> events;
+};
+
 struct comma_is_space : std::ctype<char> {
   comma_is_space() : std::ctype<char>(get_table()) {}
   static mask const* get_table()
@@ -32,9 +40,37 @@ struct comma_is_space : std::ctype<char> {
   }
 };
 
-std::vector<data_row_t> load_data(const char *filename, std::chrono::steady_clock::time_point start)
+} // namespace
+
+std::optional<flight_event_t> parse_event(const std::string& line, timestamp_t start)
 {
-  std::vector<data_row_t> result;
+  if(line.rfind(EVENT_PREFIX, 0) != 0)
+  {
+    return std::nullopt;
+  }
+  // # Event <NAME> occurred at t=<seconds> seconds
+  std::istringstream iss(line.substr(sizeof(EVENT_PREFIX) - 1));
+  std::string name, occurred, at, time;
+  if(!(iss >> name >> occurred >> at >> time) || time.rfind("t=", 0) != 0)
+  {
+    return std::nullopt;
+  }
+  // A malformed line is skipped like any other comment
+  const auto begin = time.c_str() + 2;
+  char* end;
+  const auto seconds = std::strtod(begin, &end);
+  if(end == begin || *end != '\0' || !std::isfinite(seconds))
+  {
+    return std::nullopt;
+  }
+  return flight_event_t{name, start + std::lround(seconds * 1000000.0) * 1us};
+}
+
+namespace {
+
+stage_data_t load_data(const char *filename, std::chrono::steady_clock::time_point start)
+{
+  stage_data_t result;
   std::ifstream inf(filename);
   assert(inf.is_open());
   for( std::string line; getline(inf, line);)
@@ -47,21 +83,16 @@ std::vector<data_row_t> load_data(const char *filename, std::chrono::steady_cloc
       float raw_timestamp;
       iss >> raw_timestamp >> item.totalacc >> item.pressure;
       item.time = start + (uint32_t(raw_timestamp * 1000000.0) * 1us);
-      result.emplace_back(item);
+      result.rows.emplace_back(item);
+    }
+    else if(const auto event = parse_event(line, start))
+    {
+      result.events.push_back(*event);
     }
   }
   return result;
 }
 
-void drive(const std::vector<data_row_t>& data, JuniorRocketState &state)
-{
-  for(const auto& entry : data)
-  {
-    state.drive(entry.time, entry.pressure, entry.totalacc);
-  }
-
-}
-
 std::vector<data_row_t>
 combine_data(const std::vector<data_row_t> &first_stage_data,
              const std::vector<data_row_t> &second_stage_data)
@@ -84,25 +115,162 @@ combine_data(const std::vector<data_row_t> &first_stage_data,
 
 }
 
-void load_and_drive(const char* first_stage_filename, const char* second_stage_filename, JuniorRocketState& state)
+namespace {
+
+// Loads both files with a common time base, and sorts out
+// which one is which: the first stage file ends at separation,
+// so it holds less data.
+std::pair<stage_data_t, stage_data_t>
+load_both_stages(const char* first_stage_filename, const char* second_stage_filename)
 {
   const auto start = std::chrono::steady_clock::now();
   auto first_stage_data = load_data(first_stage_filename, start);
   auto second_stage_data = load_data(second_stage_filename, start);
-  if(first_stage_data.size() == 0 || second_stage_data.size() == 0)
+  if(first_stage_data.rows.size() == 0 || second_stage_data.rows.size() == 0)
   {
     std::cerr << "Couldn't load data, check file\n";
   }
-  if(first_stage_data.size() > second_stage_data.size())
+  if(first_stage_data.rows.size() > second_stage_data.rows.size())
   {
     std::cerr << "It appears " << first_stage_filename << " contains only first stage data, swapping.\n";
-    auto h = first_stage_data;
-    first_stage_data = second_stage_data;
-    second_stage_data = h;
+    std::swap(first_stage_data, second_stage_data);
   }
-  const auto full_first_stage_data = combine_data(first_stage_data, second_stage_data);
+  return {first_stage_data, second_stage_data};
+}
+
+struct SampleCollector
+{
+  void sample(uint64_t us, float pressure, float acceleration)
+  {
+    rows.push_back({start + us * 1us, acceleration, pressure});
+  }
+  void state(uint64_t, far::junior::state) {}
+  void event(uint64_t, far::junior::event) {}
+
+  timestamp_t start;
+  std::vector<data_row_t> rows;
+};
+
+// Doesn't need any hooks, the state changes
+// come back from the block drive.
+struct SilentObserver {};
+
+}
+
+std::vector<data_row_t> load_first_stage(const char* first_stage_filename, const char* second_stage_filename)
+{
+  const auto [first_stage_data, second_stage_data] = load_both_stages(first_stage_filename, second_stage_filename);
+  const auto full_first_stage_data = combine_data(first_stage_data.rows, second_stage_data.rows);
   std::cerr << "Loaded " << full_first_stage_data.size() << " entries\n";
-  drive(full_first_stage_data, state);
+  return full_first_stage_data;
+}
+
+std::vector<track_t> load_stages(const char* first_stage_filename, const char* second_stage_filename)
+{
+  const auto [first_stage_data, second_stage_data] = load_both_stages(first_stage_filename, second_stage_filename);
+  // Up to separation, the first stage shares the events of the second
+  std::vector<flight_event_t> first_stage_events;
+  const auto cutoff_time = first_stage_data.rows[0].time;
+  std::copy_if(
+    second_stage_data.events.begin(), second_stage_data.events.end(),
+    std::back_inserter(first_stage_events),
+    [cutoff_time](const flight_event_t& e) { return e.time < cutoff_time; });
+  std::copy(
+    first_stage_data.events.begin(), first_stage_data.events.end(),
+    std::back_inserter(first_stage_events));
+
+  std::vector<track_t> result;
+  result.push_back({
+      "first stage",
+      to_sample_log(combine_data(first_stage_data.rows, second_stage_data.rows)),
+      first_stage_events
+    });
+  result.push_back({"second stage", to_sample_log(second_stage_data.rows), second_stage_data.events});
+  return result;
+}
+
+std::vector<state_change_t> detect(const sample_log_t& log, const detector_parameters_t& parameters)
+{
+  SilentObserver observer;
+  BasicJuniorRocketState<SilentObserver> detector(observer, parameters);
+  std::vector<state_change_t> changes(log.timestamps.size());
+  changes.resize(detector.drive(log.block(), changes.data()));
+  return changes;
+}
+
+std::vector<timeline_entry_t> run_tracks(const std::vector<track_t>& tracks)
+{
+  // Each worker only touches its own detector and changes
+  std::vector<std::vector<state_change_t>> changes(tracks.size());
+  std::vector<std::thread> workers;
+  for(size_t i=0; i < tracks.size(); ++i)
+  {
+    workers.emplace_back([&tracks, &changes, i]()
+    {
+      changes[i] = detect(tracks[i].samples);
+    });
+  }
+  for(auto& worker : workers)
+  {
+    worker.join();
+  }
+
+  std::vector<timeline_entry_t> timeline;
+  for(size_t i=0; i < tracks.size(); ++i)
+  {
+    for(const auto& change : changes[i])
+    {
+      timeline.push_back({i, change});
+    }
+  }
+  std::stable_sort(timeline.begin(), timeline.end(),
+    [](const timeline_entry_t& a, const timeline_entry_t& b)
+    {
+      return a.change.timestamp < b.change.timestamp;
+    });
+  return timeline;
+}
+
+std::vector<data_row_t> load_flight_log(const char* filename)
+{
+  std::ifstream inf(filename, std::ios::binary);
+  const std::vector<uint8_t> data{std::istreambuf_iterator<char>(inf), std::istreambuf_iterator<char>()};
+  SampleCollector collector{std::chrono::steady_clock::now(), {}};
+  const auto result = flight_log::decode<flight_log::PAGE_SIZE>(data.data(), data.size(), collector);
+  std::cerr << "Loaded " << collector.rows.size() << " entries from " << result.blocks << " blocks";
+  if(result.corrupt_blocks)
+  {
+    std::cerr << ", skipped " << result.corrupt_blocks << " corrupt";
+  }
+  std::cerr << "\n";
+  return collector.rows;
+}
+
+sample_log_t to_sample_log(const std::vector<data_row_t>& data)
+{
+  sample_log_t result;
+  result.timestamps.reserve(data.size());
+  result.pressures.reserve(data.size());
+  result.accelerations.reserve(data.size());
+  for(const auto& entry : data)
+  {
+    result.timestamps.push_back(entry.time);
+    result.pressures.push_back(entry.pressure);
+    result.accelerations.push_back(entry.totalacc);
+  }
+  return result;
+}
+
+std::vector<state_change_t> drive_block(const sample_log_t& log, JuniorRocketState& state)
+{
+  std::vector<state_change_t> changes(log.timestamps.size());
+  changes.resize(state.drive(log.block(), changes.data()));
+  return changes;
+}
+
+void load_and_drive(const char* first_stage_filename, const char* second_stage_filename, JuniorRocketState& state)
+{
+  drive_block(to_sample_log(load_first_stage(first_stage_filename, second_stage_filename)), state);
 }
 
 }
@@ -3,8 +3,92 @@
 
 #include "junior-rocket-state.hpp"
 
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace far::junior {
 
+struct data_row_t {
+  timestamp_t time;
+  float totalacc;
+  float pressure;
+};
+
+// Loads both stages and combines them into the data
+// the first stage flight computer sees.
+std::vector<data_row_t> load_first_stage(const char* first_stage_filename, const char* second_stage_filename);
+
+// Works with anything that has a JuniorRocketState compatible
+// drive(), so preprocessing stages can be put in front.
+template<typename Driver>
+void drive(const std::vector<data_row_t>& data, Driver& driver)
+{
+  for(const auto& entry : data)
+  {
+    driver.drive(entry.time, entry.pressure, entry.totalacc);
+  }
+}
+
+// The same rows in structure of arrays layout,
+// for JuniorRocketState's block drive.
+struct sample_log_t {
+  std::vector<timestamp_t> timestamps;
+  std::vector<float> pressures;
+  std::vector<float> accelerations;
+
+  sample_block_t block() const
+  {
+    return {timestamps.data(), pressures.data(), accelerations.data(), timestamps.size()};
+  }
+};
+
+sample_log_t to_sample_log(const std::vector<data_row_t>& data);
+
+// Drives the whole log as one block, and returns the state changes.
+std::vector<state_change_t> drive_block(const sample_log_t& log, JuniorRocketState&);
+
+// Runs a fresh detector without any observer over the
+// log, the fastest way to get the state changes.
+std::vector<state_change_t> detect(const sample_log_t& log, const detector_parameters_t& parameters={});
+
+// What really happened according to the simulation, from the
+// "# Event APOGEE occurred at t=6.565 seconds" comments.
+struct flight_event_t {
+  std::string name;
+  timestamp_t time;
+};
+
+// The event of such a comment relative to start, rounded to
+// the microsecond, or nothing for any other line.
+std::optional<flight_event_t> parse_event(const std::string& line, timestamp_t start);
+
+// One flight computer's view of the flight
+struct track_t {
+  std::string name;
+  sample_log_t samples;
+  std::vector<flight_event_t> events;
+};
+
+// Both stages as their own flight computers see them. The
+// first stage carries the second until separation, so it
+// sees the second stage data up to then.
+std::vector<track_t> load_stages(const char* first_stage_filename, const char* second_stage_filename);
+
+struct timeline_entry_t {
+  // Index into the tracks
+  size_t track;
+  state_change_t change;
+};
+
+// Runs a detector per track, each on its own thread, and
+// merges their state changes into one timeline.
+std::vector<timeline_entry_t> run_tracks(const std::vector<track_t>& tracks);
+
+// Reads the samples back from a flight log written
+// by a FlightRecorder with the default page size.
+std::vector<data_row_t> load_flight_log(const char* filename);
+
 void load_and_drive(const char* first_stage_filename, const char* second_stage_filename, JuniorRocketState&);
 
 }
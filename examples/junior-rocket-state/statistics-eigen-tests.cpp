@@ -0,0 +1,25 @@
+#include "statistics.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <Eigen/Eigen>
+
+using namespace deets::statistics;
+
+TEST_CASE("Multivariate statistics with Eigen types", "[statistics]")
+{
+  RollingMultivariateStatistics<float, 3, 16> stats;
+  std::optional<decltype(stats)::result_t> result;
+  for(auto i=0; i < 40; ++i)
+  {
+    const float pressure = 1000.0f - 0.1f * float(i % 5);
+    const float acceleration = 20.0f + float(i % 5);
+    const Eigen::Vector3f sample{pressure, acceleration, float(i % 3)};
+    result = stats.update(sample);
+  }
+  const Eigen::Map<const Eigen::Matrix<float, 3, 3, Eigen::RowMajor>> covariance(result->covariance.data());
+  REQUIRE(covariance(0, 1) == Catch::Approx(-0.1f * covariance(1, 1)).epsilon(1e-3));
+  REQUIRE((covariance - covariance.transpose()).norm() == Catch::Approx(0.0f).margin(1e-6));
+  REQUIRE(result->correlation(0, 1) == Catch::Approx(-1.0f).epsilon(1e-3));
+}
@@ -0,0 +1,136 @@
+#include "junior-rocket-state-impl.hpp"
+#include "sweep.hpp"
+#include "synthetic-flight.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace far::junior;
+
+TEST_CASE("Detector parameters", "[sweep]")
+{
+  const auto track = synthetic_track("synthetic");
+  const auto nominal = detect(track.samples);
+  const auto launched = [](const std::vector<state_change_t>& changes)
+  {
+    return std::any_of(changes.begin(), changes.end(),
+      [](const state_change_t& c) { return c.to == state::LAUNCHED; });
+  };
+  REQUIRE(launched(nominal));
+
+  SECTION("The defaults are the constants")
+  {
+    StateObserver nop;
+    JuniorRocketState rocket(nop);
+    REQUIRE(rocket.parameters().launch_acceleration_threshold == LAUNCH_ACCELERATION_THRESHOLD);
+    REQUIRE(rocket.parameters().motor_burntime == timeouts::MOTOR_BURNTIME);
+  }
+
+  SECTION("A launch threshold above the thrust never launches")
+  {
+    detector_parameters_t parameters;
+    parameters.launch_acceleration_threshold = 40.0f;
+    REQUIRE(!launched(detect(track.samples, parameters)));
+  }
+
+  SECTION("A longer acceleration timeout delays the launch")
+  {
+    detector_parameters_t parameters;
+    parameters.acceleration_timeout = 800ms;
+    const auto changes = detect(track.samples, parameters);
+    const auto accelerating = [](const std::vector<state_change_t>& changes)
+    {
+      return std::find_if(changes.begin(), changes.end(),
+        [](const state_change_t& c) { return c.to == state::ACCELERATING; })->timestamp;
+    };
+    REQUIRE(accelerating(changes) - accelerating(nominal) == 400ms);
+  }
+}
+
+TEST_CASE("Sweep scoring", "[sweep]")
+{
+  const auto track = synthetic_track("synthetic");
+  const auto start = timestamp_t{};
+
+  SECTION("Latency is measured from the true event")
+  {
+    const std::vector<state_change_t> changes{
+      {start + 1200ms, state::LAUNCHED},
+      {start + 3100ms, state::BURNOUT},
+      {start + 7500ms, state::FALLING_},
+    };
+    const auto result = score(track, changes);
+    REQUIRE(result.false_triggers == 0);
+    REQUIRE(result.missed == 0);
+    REQUIRE(result.latency == 800ms);
+  }
+
+  SECTION("Early and unexpected detections are false triggers")
+  {
+    const std::vector<state_change_t> changes{
+      {start + 500ms, state::LAUNCHED},
+      {start + 3100ms, state::BURNOUT},
+      {start + 7500ms, state::FALLING_},
+      {start + 9s, state::DROUGE_OPENED},
+    };
+    const auto result = score(track, changes);
+    REQUIRE(result.false_triggers == 2);
+    REQUIRE(result.latency == 600ms);
+  }
+
+  SECTION("Undetected events are missed")
+  {
+    const std::vector<state_change_t> changes{
+      {start + 1200ms, state::LAUNCHED},
+    };
+    REQUIRE(score(track, changes).missed == 2);
+  }
+
+  SECTION("Fewer mistakes beat lower latency")
+  {
+    REQUIRE(score_t{10s, 0, 0} < score_t{0s, 1, 0});
+    REQUIRE(score_t{1s, 0, 1} < score_t{2s, 1, 0} );
+  }
+}
+
+TEST_CASE("Parallel sweep", "[sweep]")
+{
+  const std::vector<track_t> tracks{synthetic_track("synthetic")};
+  std::mt19937 generator(42);
+  std::vector<detector_parameters_t> configurations(1);
+  for(int i=0; i < 99; ++i)
+  {
+    configurations.push_back(random_parameters(generator));
+  }
+  const auto results = sweep(tracks, configurations, 4);
+  REQUIRE(results.size() == configurations.size());
+
+  SECTION("The results are ranked")
+  {
+    REQUIRE(std::is_sorted(results.begin(), results.end(),
+      [](const sweep_result_t& a, const sweep_result_t& b) { return a.score < b.score; }));
+  }
+
+  SECTION("Each result is the score of its own configuration")
+  {
+    for(const auto& result : results)
+    {
+      const auto expected = score(tracks[0], detect(tracks[0].samples, configurations[result.configuration]));
+      REQUIRE(result.score.latency == expected.latency);
+      REQUIRE(result.score.false_triggers == expected.false_triggers);
+      REQUIRE(result.score.missed == expected.missed);
+    }
+  }
+
+  SECTION("A single thread gives the same ranking")
+  {
+    const auto sequential = sweep(tracks, configurations, 1);
+    for(size_t i=0; i < results.size(); ++i)
+    {
+      REQUIRE(sequential[i].configuration == results[i].configuration);
+    }
+  }
+}
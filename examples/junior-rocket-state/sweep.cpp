@@ -0,0 +1,127 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <tuple>
+
+namespace far::junior {
+
+namespace {
+
+// Configurations a worker takes at once, so
+// the shared counter isn't contended
+constexpr size_t SWEEP_CHUNK = 16;
+
+duration_t uniform(std::mt19937& generator, duration_t low, duration_t high)
+{
+  std::uniform_int_distribution<int64_t> distribution(low / 1us, high / 1us);
+  return distribution(generator) * 1us;
+}
+
+float uniform(std::mt19937& generator, float low, float high)
+{
+  return std::uniform_real_distribution<float>(low, high)(generator);
+}
+
+}
+
+score_t& score_t::operator+=(const score_t& other)
+{
+  latency += other.latency;
+  false_triggers += other.false_triggers;
+  missed += other.missed;
+  return *this;
+}
+
+bool score_t::operator<(const score_t& other) const
+{
+  return std::make_tuple(false_triggers + missed, latency)
+    < std::make_tuple(other.false_triggers + other.missed, other.latency);
+}
+
+score_t score(const track_t& track, const std::vector<state_change_t>& changes)
+{
+  score_t result;
+  for(const auto& detection : match(track, changes))
+  {
+    if(detection.early() || detection.unexpected())
+    {
+      ++result.false_triggers;
+    }
+    else if(detection.missed())
+    {
+      ++result.missed;
+    }
+    else if(const auto latency = detection.latency())
+    {
+      result.latency += *latency;
+    }
+  }
+  return result;
+}
+
+detector_parameters_t random_parameters(std::mt19937& generator)
+{
+  detector_parameters_t p;
+  p.launch_acceleration_threshold = uniform(generator, 8.0f, 30.0f);
+  p.freefall_acceleration_threshold = uniform(generator, 0.5f, 6.0f);
+  p.launch_pressure_differential = uniform(generator, 1.0f, 10.0f);
+  p.peak_pressure_margin = uniform(generator, 0.1f, 2.0f);
+  p.apogee_time = uniform(generator, 4s, 14s);
+  p.apogee_detection_margin = uniform(generator, 0s, 6s);
+  p.pressure_variance_threshold = uniform(generator, 1.0f, 5.0f);
+  p.pressure_drop_significance = uniform(generator, 4.0f, 20.0f);
+  p.pressure_drop_curvature = uniform(generator, 0.1f, 1.0f);
+  p.acceleration_timeout = uniform(generator, 100ms, 800ms);
+  p.separation_timeout = uniform(generator, 500ms, 2s);
+  p.motor_burntime = uniform(generator, 1500ms, 4s);
+  p.falling_pressure_timeout = uniform(generator, 300ms, 1500ms);
+  return p;
+}
+
+std::vector<sweep_result_t> sweep(
+  const std::vector<track_t>& tracks,
+  const std::vector<detector_parameters_t>& configurations,
+  unsigned threads
+  )
+{
+  if(threads == 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::vector<sweep_result_t> results(configurations.size());
+  std::atomic<size_t> next{0};
+  const auto work = [&]()
+  {
+    for(auto first = next.fetch_add(SWEEP_CHUNK); first < configurations.size(); first = next.fetch_add(SWEEP_CHUNK))
+    {
+      const auto last = std::min(first + SWEEP_CHUNK, configurations.size());
+      for(auto i = first; i < last; ++i)
+      {
+        auto& result = results[i];
+        result.configuration = i;
+        result.parameters = configurations[i];
+        for(const auto& track : tracks)
+        {
+          result.score += score(track, detect(track.samples, configurations[i]));
+        }
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for(unsigned i=1; i < threads; ++i)
+  {
+    workers.emplace_back(work);
+  }
+  work();
+  for(auto& worker : workers)
+  {
+    worker.join();
+  }
+  std::stable_sort(results.begin(), results.end(),
+    [](const sweep_result_t& a, const sweep_result_t& b) { return a.score < b.score; });
+  return results;
+}
+
+} // namespace far::junior
@@ -0,0 +1,49 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "latency.hpp"
+
+#include <random>
+#include <vector>
+
+namespace far::junior {
+
+// How a detector configuration does on one or more flights,
+// the DETECTIONS summed up into one comparable figure.
+struct score_t {
+  // From the true events to their detections
+  duration_t latency = duration_t::zero();
+  // Detections before the event happened, or of
+  // events that never happened at all
+  int false_triggers = 0;
+  // Events that were never detected
+  int missed = 0;
+
+  score_t& operator+=(const score_t& other);
+  // Fewer mistakes first, then the lower latency
+  bool operator<(const score_t& other) const;
+};
+
+score_t score(const track_t& track, const std::vector<state_change_t>& changes);
+
+// A uniform draw from a plausible range for each parameter
+detector_parameters_t random_parameters(std::mt19937& generator);
+
+struct sweep_result_t {
+  // Index into the configurations
+  size_t configuration;
+  detector_parameters_t parameters;
+  score_t score;
+};
+
+// Scores every configuration over all tracks, spread over the
+// given number of threads, or all cores for zero. The tracks
+// are only read. The results come back best first.
+std::vector<sweep_result_t> sweep(
+  const std::vector<track_t>& tracks,
+  const std::vector<detector_parameters_t>& configurations,
+  unsigned threads=0
+  );
+
+} // namespace far::junior
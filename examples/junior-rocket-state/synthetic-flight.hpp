@@ -0,0 +1,61 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "simulator.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace far::junior {
+
+// A made up flight for the tests, sampled at 20Hz: calm on the
+// pad, thrust from the launch until burnout, climbing at 4 mbar/s
+// until apogee, then the pressure rises again.
+struct synthetic_flight_t {
+  int samples = 400;
+  float launch_time = 1.0f;
+  float burn_time = 2.0f;
+  float climb_time = 6.0f;
+  // In mbar/s, zero to stay at the apogee
+  float descent_rate = 1.5f;
+};
+
+inline std::vector<data_row_t> synthetic_flight(const synthetic_flight_t& flight={})
+{
+  std::vector<data_row_t> result;
+  const auto start = timestamp_t{};
+  const auto apogee = flight.launch_time + flight.climb_time;
+  for(int i=0; i < flight.samples; ++i)
+  {
+    const auto t = i * 0.05f;
+    const auto flying = t >= flight.launch_time;
+    const auto burning = flying && t < flight.launch_time + flight.burn_time;
+    const auto climb = flying ? std::min(t - flight.launch_time, flight.climb_time) : 0.0f;
+    const auto pressure = 1000.0f - climb * 4.0f + (t > apogee ? (t - apogee) * flight.descent_rate : 0.0f);
+    result.push_back({start + i * 50ms, burning ? 30.0f : 1.0f, pressure});
+  }
+  return result;
+}
+
+// The same as a track, with its launch, burnout and apogee
+inline track_t synthetic_track(const std::string& name, const synthetic_flight_t& flight={})
+{
+  const auto start = timestamp_t{};
+  const auto at = [start](float seconds)
+  {
+    return start + std::chrono::duration_cast<duration_t>(std::chrono::duration<float>(seconds));
+  };
+  return {
+    name,
+    to_sample_log(synthetic_flight(flight)),
+    {
+      {"LAUNCH", at(flight.launch_time)},
+      {"BURNOUT", at(flight.launch_time + flight.burn_time)},
+      {"APOGEE", at(flight.launch_time + flight.climb_time)},
+    }
+  };
+}
+
+} // namespace far::junior
@@ -0,0 +1,185 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+#include "spsc-ring.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+namespace deets::log {
+
+enum class level : uint8_t
+{
+  TRACE,
+  DEBUG,
+  INFO,
+  WARNING,
+  ERROR,
+  // Only useful as the minimum level, disables everything
+  OFF
+};
+
+constexpr const char* level_name(level l)
+{
+  constexpr const char* NAMES[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "OFF"};
+  return NAMES[static_cast<size_t>(l)];
+}
+
+// One log call. Only the message id and the arguments are
+// stored, the format string lives in a table that the decoder
+// knows about. The sequence number exposes dropped records.
+template<size_t MaxArgs>
+struct record_t
+{
+  uint32_t sequence;
+  uint16_t message;
+  level severity;
+  uint8_t argc;
+  std::array<float, MaxArgs> args;
+};
+
+// Where a log keeps its records, a private base so a
+// disabled log without a ring takes no space at all.
+template<typename Record, size_t Capacity, bool Enabled>
+struct log_storage
+{
+  concurrent::SpscRing<Record, Capacity> ring;
+  uint32_t sequence = 0;
+};
+
+template<typename Record, size_t Capacity>
+struct log_storage<Record, Capacity, false> {};
+
+// A binary logger that writes fixed-size records into a lock-free
+// single producer, single consumer ring. Calls below MinLevel
+// compile to nothing. A full ring drops the new record and counts
+// it as an overrun, so the producer never blocks. With MinLevel
+// OFF the log is an empty type.
+//
+// Message is an enum naming the format strings.
+template<typename Message, level MinLevel, size_t Capacity=256, size_t MaxArgs=3>
+class BinaryLog : private log_storage<record_t<MaxArgs>, Capacity, MinLevel != level::OFF>
+{
+public:
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+  using record_type = record_t<MaxArgs>;
+  static constexpr bool ENABLED = MinLevel != level::OFF;
+
+  template<level Level, typename... Args>
+  void log(Message message, Args... args)
+  {
+    if constexpr (Level >= MinLevel && ENABLED)
+    {
+      static_assert(sizeof...(Args) <= MaxArgs, "Too many arguments for a record");
+      this->ring.push(record_type{
+          this->sequence++,
+          static_cast<uint16_t>(message),
+          Level,
+          uint8_t(sizeof...(Args)),
+          {float(args)...}
+        });
+    }
+    else
+    {
+      (void)message;
+      ((void)args, ...);
+    }
+  }
+
+  template<typename... Args>
+  void trace(Message message, Args... args) { log<level::TRACE>(message, args...); }
+  template<typename... Args>
+  void debug(Message message, Args... args) { log<level::DEBUG>(message, args...); }
+  template<typename... Args>
+  void info(Message message, Args... args) { log<level::INFO>(message, args...); }
+  template<typename... Args>
+  void warning(Message message, Args... args) { log<level::WARNING>(message, args...); }
+  template<typename... Args>
+  void error(Message message, Args... args) { log<level::ERROR>(message, args...); }
+
+  // Consumer side
+  bool pop(record_type& record)
+  {
+    if constexpr (ENABLED)
+    {
+      return this->ring.pop(record);
+    }
+    else
+    {
+      (void)record;
+      return false;
+    }
+  }
+
+  // Hands all pending records to the sink, returns how many
+  template<typename Sink>
+  size_t drain(Sink&& sink)
+  {
+    size_t count = 0;
+    if constexpr (ENABLED)
+    {
+      std::array<record_type, 16> batch;
+      while(const auto popped = this->ring.pop(batch.data(), batch.size()))
+      {
+        for(size_t i=0; i < popped; ++i)
+        {
+          sink(batch[i]);
+        }
+        count += popped;
+      }
+    }
+    else
+    {
+      (void)sink;
+    }
+    return count;
+  }
+
+  size_t size() const
+  {
+    if constexpr (ENABLED)
+    {
+      return this->ring.size();
+    }
+    return 0;
+  }
+
+  uint32_t dropped() const
+  {
+    if constexpr (ENABLED)
+    {
+      return this->ring.overruns();
+    }
+    return 0;
+  }
+};
+
+// Renders a record offline, replacing each {} in the format
+// with the next argument.
+template<size_t MaxArgs>
+std::string render(const record_t<MaxArgs>& record, const char* format)
+{
+  std::string result;
+  size_t arg = 0;
+  for(const char* c=format; *c; ++c)
+  {
+    if(c[0] == '{' && c[1] == '}' && arg < record.argc)
+    {
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%g", double(record.args[arg++]));
+      result += buffer;
+      ++c;
+    }
+    else
+    {
+      result += *c;
+    }
+  }
+  return result;
+}
+
+} // namespace deets::log
@@ -0,0 +1,122 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// The std:: math functions aren't constexpr in C++17. These are,
+// so filter coefficients and tables can be computed at compile
+// time. They are accurate to about double precision within the
+// ranges they are used for, but slow, so don't call them at
+// runtime.
+namespace deets::cmath {
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double abs(double x)
+{
+  return x < 0 ? -x : x;
+}
+
+constexpr double sin(double x)
+{
+  // Reduce to [-pi, pi] to keep the series short
+  const auto turns = x / (2 * PI);
+  const auto whole = double(static_cast<long long>(turns + (turns < 0 ? -0.5 : 0.5)));
+  x -= whole * 2 * PI;
+  double term = x, result = x;
+  for(int i=1; i < 30; ++i)
+  {
+    term *= -x * x / ((2 * i) * (2 * i + 1));
+    result += term;
+  }
+  return result;
+}
+
+constexpr double cos(double x)
+{
+  return sin(x + PI / 2);
+}
+
+constexpr double tan(double x)
+{
+  return sin(x) / cos(x);
+}
+
+constexpr double sqrt(double x)
+{
+  if(x <= 0)
+  {
+    return 0;
+  }
+  double result = x < 1 ? 1 : x;
+  for(int i=0; i < 100; ++i)
+  {
+    const auto next = (result + x / result) / 2;
+    if(next == result)
+    {
+      break;
+    }
+    result = next;
+  }
+  return result;
+}
+
+constexpr double LN2 = 0.69314718055994530942;
+
+constexpr double exp(double x)
+{
+  // Split off whole powers of two, e^x = 2^k * e^r with |r| <= ln2 / 2
+  const auto k = static_cast<long long>(x / LN2 + (x < 0 ? -0.5 : 0.5));
+  const auto r = x - double(k) * LN2;
+  double term = 1, result = 1;
+  for(int i=1; i < 30; ++i)
+  {
+    term *= r / i;
+    result += term;
+  }
+  for(long long i=0; i < k; ++i)
+  {
+    result *= 2;
+  }
+  for(long long i=0; i > k; --i)
+  {
+    result /= 2;
+  }
+  return result;
+}
+
+constexpr double log(double x)
+{
+  if(x <= 0)
+  {
+    return 0;
+  }
+  // Scale into [0.5, 1), then use the atanh series
+  // log(x) = 2 * atanh((x - 1) / (x + 1))
+  int k = 0;
+  while(x >= 1)
+  {
+    x /= 2;
+    ++k;
+  }
+  while(x < 0.5)
+  {
+    x *= 2;
+    --k;
+  }
+  const auto y = (x - 1) / (x + 1);
+  double term = y, result = 0;
+  for(int i=0; i < 60; ++i)
+  {
+    result += term / (2 * i + 1);
+    term *= y * y;
+  }
+  return 2 * result + k * LN2;
+}
+
+// Only for positive bases
+constexpr double pow(double base, double exponent)
+{
+  return exp(exponent * log(base));
+}
+
+} // namespace deets::cmath
@@ -0,0 +1,529 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+#include "statistics.hpp"
+#include "constexpr-math.hpp"
+
+#include <cmath>
+#include <array>
+
+namespace deets::filters {
+
+// A stage that leaves its input untouched, for
+// pipelines that only filter some of their channels.
+template<typename F>
+struct Passthrough
+{
+  F filter(F value)
+  {
+    return value;
+  }
+};
+
+// Streaming Hampel filter: a sample that deviates from the
+// median of the last N samples by more than threshold times
+// the scaled median absolute deviation is replaced by that
+// median. Until the window is filled, samples pass unchanged.
+// As a flat signal has a MAD of zero, deviations up to
+// min_deviation are always accepted.
+template<typename F, int N>
+class HampelFilter
+{
+public:
+  // Makes the MAD a consistent estimator of the
+  // standard deviation for normally distributed data.
+  static constexpr F MAD_SCALE = F(1.4826);
+
+  HampelFilter(F threshold=F(3), F min_deviation=F(0))
+    : _threshold(threshold)
+    , _min_deviation(min_deviation)
+  {}
+
+  F filter(F value)
+  {
+    const auto median = _window.update(value);
+    if(median)
+    {
+      const auto limit = std::max(_threshold * MAD_SCALE * _window.mad(), _min_deviation);
+      if(std::abs(value - *median) > limit)
+      {
+        ++_replaced;
+        return *median;
+      }
+    }
+    return value;
+  }
+
+  size_t replaced() const { return _replaced; }
+
+private:
+  deets::statistics::SlidingMedian<F, N> _window;
+  F _threshold;
+  F _min_deviation;
+  size_t _replaced = 0;
+};
+
+// Coefficients of a biquad section, normalized to a0 = 1.
+template<typename F>
+struct biquad_coefficients_t
+{
+  F b0, b1, b2;
+  F a1, a2;
+};
+
+template<typename F, int Sections>
+using biquad_cascade_t = std::array<biquad_coefficients_t<F>, Sections>;
+
+enum class response
+{
+  LOWPASS,
+  HIGHPASS,
+};
+
+// Designs a Butterworth filter of order 2 * Sections as cascaded
+// biquads, using the bilinear transform (the "Audio EQ Cookbook"
+// sections with the Butterworth pole Qs). Meant to be evaluated
+// at compile time.
+template<typename F, int Sections>
+constexpr biquad_cascade_t<F, Sections> butterworth(response kind, double cutoff, double sample_rate)
+{
+  using namespace deets::cmath;
+  biquad_cascade_t<F, Sections> result{};
+  const auto w0 = 2 * PI * cutoff / sample_rate;
+  const auto cos_w0 = cos(w0);
+  const auto sin_w0 = sin(w0);
+  for(int k=0; k < Sections; ++k)
+  {
+    const auto q = 1 / (2 * cos(PI * (2 * k + 1) / (4 * Sections)));
+    const auto alpha = sin_w0 / (2 * q);
+    const auto a0 = 1 + alpha;
+    const auto b1 = kind == response::LOWPASS ? 1 - cos_w0 : -(1 + cos_w0);
+    const auto b0 = kind == response::LOWPASS ? b1 / 2 : -b1 / 2;
+    result[k] = {
+      F(b0 / a0), F(b1 / a0), F(b0 / a0),
+      F(-2 * cos_w0 / a0), F((1 - alpha) / a0)
+    };
+  }
+  return result;
+}
+
+template<typename F, int Sections>
+constexpr biquad_cascade_t<F, Sections> butterworth_lowpass(double cutoff, double sample_rate)
+{
+  return butterworth<F, Sections>(response::LOWPASS, cutoff, sample_rate);
+}
+
+template<typename F, int Sections>
+constexpr biquad_cascade_t<F, Sections> butterworth_highpass(double cutoff, double sample_rate)
+{
+  return butterworth<F, Sections>(response::HIGHPASS, cutoff, sample_rate);
+}
+
+// Cascaded biquads in transposed direct form II, five
+// multiply-adds per section and sample. The first sample primes
+// the state as if it had been applied forever, so there's no
+// start-up transient when filtering e.g. absolute pressures.
+template<typename F, int Sections>
+class BiquadCascade
+{
+public:
+  using coefficients_t = biquad_cascade_t<F, Sections>;
+
+  constexpr BiquadCascade(const coefficients_t& coefficients)
+    : _coefficients(coefficients)
+  {}
+
+  F filter(F value)
+  {
+    if(!_primed)
+    {
+      prime(value);
+    }
+    for(int k=0; k < Sections; ++k)
+    {
+      const auto& c = _coefficients[k];
+      const auto output = c.b0 * value + _s1[k];
+      _s1[k] = c.b1 * value - c.a1 * output + _s2[k];
+      _s2[k] = c.b2 * value - c.a2 * output;
+      value = output;
+    }
+    return value;
+  }
+
+  template<typename InputIt, typename OutputIt>
+  OutputIt filter(InputIt first, InputIt last, OutputIt out)
+  {
+    for(; first != last; ++first, ++out)
+    {
+      *out = filter(*first);
+    }
+    return out;
+  }
+
+  // Sets the state to the steady state for a constant input
+  void prime(F value)
+  {
+    for(int k=0; k < Sections; ++k)
+    {
+      const auto& c = _coefficients[k];
+      const auto gain = (c.b0 + c.b1 + c.b2) / (1 + c.a1 + c.a2);
+      const auto output = value * gain;
+      _s2[k] = c.b2 * value - c.a2 * output;
+      _s1[k] = c.b1 * value - c.a1 * output + _s2[k];
+      value = output;
+    }
+    _primed = true;
+  }
+
+private:
+  coefficients_t _coefficients;
+  std::array<F, Sections> _s1{};
+  std::array<F, Sections> _s2{};
+  bool _primed = false;
+};
+
+// The same cascade applied to Channels signals at once. The state
+// is stored per section as arrays over the channels (structure of
+// arrays), so the inner loops run across channels and vectorize.
+template<typename F, int Sections, int Channels>
+class BiquadCascadeBank
+{
+public:
+  using coefficients_t = biquad_cascade_t<F, Sections>;
+  using sample_t = std::array<F, Channels>;
+
+  constexpr BiquadCascadeBank(const coefficients_t& coefficients)
+    : _coefficients(coefficients)
+  {}
+
+  // Filters one sample of all channels in place
+  void filter(sample_t& values)
+  {
+    if(!_primed)
+    {
+      prime(values);
+    }
+    for(int k=0; k < Sections; ++k)
+    {
+      const auto c = _coefficients[k];
+      auto& s1 = _s1[k];
+      auto& s2 = _s2[k];
+      for(int channel=0; channel < Channels; ++channel)
+      {
+        const auto value = values[channel];
+        const auto output = c.b0 * value + s1[channel];
+        s1[channel] = c.b1 * value - c.a1 * output + s2[channel];
+        s2[channel] = c.b2 * value - c.a2 * output;
+        values[channel] = output;
+      }
+    }
+  }
+
+  void prime(const sample_t& values)
+  {
+    sample_t current = values;
+    for(int k=0; k < Sections; ++k)
+    {
+      const auto& c = _coefficients[k];
+      const auto gain = (c.b0 + c.b1 + c.b2) / (1 + c.a1 + c.a2);
+      for(int channel=0; channel < Channels; ++channel)
+      {
+        const auto output = current[channel] * gain;
+        _s2[k][channel] = c.b2 * current[channel] - c.a2 * output;
+        _s1[k][channel] = c.b1 * current[channel] - c.a1 * output + _s2[k][channel];
+        current[channel] = output;
+      }
+    }
+    _primed = true;
+  }
+
+private:
+  coefficients_t _coefficients;
+  std::array<sample_t, Sections> _s1{};
+  std::array<sample_t, Sections> _s2{};
+  bool _primed = false;
+};
+
+// Lowpass FIR taps from a Blackman windowed sinc. The cutoff is
+// relative to the sample rate (0.5 being Nyquist), the taps sum
+// up to gain. Meant to be evaluated at compile time.
+template<typename F, size_t Taps>
+constexpr std::array<F, Taps> windowed_sinc_lowpass(double cutoff, double gain=1.0)
+{
+  using namespace deets::cmath;
+  std::array<double, Taps> taps{};
+  double sum = 0;
+  const auto middle = (Taps - 1) / 2.0;
+  for(size_t i=0; i < Taps; ++i)
+  {
+    const auto x = 2 * PI * cutoff * (i - middle);
+    const auto sinc = abs(x) < 1e-12 ? 1.0 : sin(x) / x;
+    const auto phase = Taps > 1 ? 2 * PI * i / (Taps - 1) : 0.0;
+    const auto window = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2 * phase);
+    taps[i] = sinc * window;
+    sum += taps[i];
+  }
+  std::array<F, Taps> result{};
+  for(size_t i=0; i < Taps; ++i)
+  {
+    result[i] = F(taps[i] * gain / sum);
+  }
+  return result;
+}
+
+// The length of each of the Up phases when resampling by Up / Down.
+// The cutoff narrows with max(Up, Down), so the lowpass needs that
+// many times TapsPerPhase taps to keep its transition band, and
+// with it the stopband attenuation, the same.
+constexpr int polyphase_taps(int up, int down, int taps_per_phase)
+{
+  return (std::max(up, down) * taps_per_phase + up - 1) / up;
+}
+
+// Splits the anti-aliasing lowpass for resampling by Up / Down
+// into its Up phases.
+template<typename F, int Up, int Down, int TapsPerPhase>
+constexpr std::array<std::array<F, polyphase_taps(Up, Down, TapsPerPhase)>, Up> polyphase_lowpass()
+{
+  constexpr int PHASE_TAPS = polyphase_taps(Up, Down, TapsPerPhase);
+  constexpr auto taps = windowed_sinc_lowpass<F, Up * PHASE_TAPS>(0.4 / std::max(Up, Down), Up);
+  std::array<std::array<F, PHASE_TAPS>, Up> phases{};
+  for(int phase=0; phase < Up; ++phase)
+  {
+    for(int k=0; k < PHASE_TAPS; ++k)
+    {
+      phases[phase][k] = taps[phase + k * Up];
+    }
+  }
+  return phases;
+}
+
+// Rational resampling by Up / Down with a polyphase FIR. The
+// anti-aliasing lowpass has max(Up, Down) * TapsPerPhase taps and
+// its cutoff at 80% of the lower of both Nyquist frequencies. It is
+// split into Up phases at compile time, and samples that decimation
+// would throw away are never computed. Interpolating, each output
+// sample costs TapsPerPhase multiply-adds. Decimating by Down, each
+// output sums Down branches of TapsPerPhase taps, which is the same
+// TapsPerPhase multiply-adds per input sample.
+//
+// Like BiquadCascade, the history is primed from the first sample.
+template<typename F, int Up, int Down, int TapsPerPhase>
+class PolyphaseResampler
+{
+public:
+  static_assert(Up > 0 && Down > 0 && TapsPerPhase > 0, "Invalid resampler");
+  static constexpr int PHASE_TAPS = polyphase_taps(Up, Down, TapsPerPhase);
+  static constexpr int TAPS = Up * PHASE_TAPS;
+  // The latency in input samples
+  static constexpr double GROUP_DELAY = (TAPS - 1) / 2.0 / Up;
+
+  using phases_t = std::array<std::array<F, PHASE_TAPS>, Up>;
+
+  static constexpr phases_t PHASES = polyphase_lowpass<F, Up, Down, TapsPerPhase>();
+
+  // Feeds one input sample, writes the zero or more
+  // output samples it completes to out.
+  template<typename OutputIt>
+  OutputIt update(F value, OutputIt out)
+  {
+    push(value);
+    for(; _position < Up; _position += Down)
+    {
+      *out++ = convolve(PHASES[_position]);
+    }
+    _position -= Up;
+    return out;
+  }
+
+  template<typename InputIt, typename OutputIt>
+  OutputIt update(InputIt first, InputIt last, OutputIt out)
+  {
+    for(; first != last; ++first)
+    {
+      out = update(*first, out);
+    }
+    return out;
+  }
+
+private:
+  void push(F value)
+  {
+    if(!_primed)
+    {
+      _history.fill(value);
+      _primed = true;
+    }
+    // Every sample is stored twice, so the newest
+    // PHASE_TAPS samples are always contiguous.
+    _head = _head == 0 ? PHASE_TAPS - 1 : _head - 1;
+    _history[_head] = value;
+    _history[_head + PHASE_TAPS] = value;
+  }
+
+  F convolve(const std::array<F, PHASE_TAPS>& phase) const
+  {
+    F result{};
+    const auto* history = &_history[_head];
+    for(int k=0; k < PHASE_TAPS; ++k)
+    {
+      result += phase[k] * history[k];
+    }
+    return result;
+  }
+
+  std::array<F, 2 * PHASE_TAPS> _history{};
+  int _head = 0;
+  int _position = 0;
+  bool _primed = false;
+};
+
+template<typename F, int Factor, int TapsPerPhase>
+using Decimator = PolyphaseResampler<F, 1, Factor, TapsPerPhase>;
+
+// Convolution coefficients of a Savitzky-Golay filter: a least
+// squares polynomial of Order through Window samples, evaluated
+// Lag samples behind the newest one. Row d yields the d-th
+// derivative (per sample), column k weighs the sample k behind
+// the newest. The normal equations are solved at compile time.
+template<typename F, int Window, int Order, int Lag>
+constexpr std::array<std::array<F, Window>, 3> savitzky_golay_coefficients()
+{
+  constexpr int M = Order + 1;
+  // Normal matrix J^T J next to the identity, for Gauss-Jordan
+  std::array<std::array<double, 2 * M>, M> a{};
+  for(int row=0; row < M; ++row)
+  {
+    for(int column=0; column < M; ++column)
+    {
+      double sum = 0;
+      for(int k=0; k < Window; ++k)
+      {
+        double power = 1;
+        for(int p=0; p < row + column; ++p)
+        {
+          power *= Lag - k;
+        }
+        sum += power;
+      }
+      a[row][column] = sum;
+    }
+    a[row][M + row] = 1;
+  }
+  for(int pivot=0; pivot < M; ++pivot)
+  {
+    int best = pivot;
+    for(int row=pivot + 1; row < M; ++row)
+    {
+      if(deets::cmath::abs(a[row][pivot]) > deets::cmath::abs(a[best][pivot]))
+      {
+        best = row;
+      }
+    }
+    for(int column=0; column < 2 * M; ++column)
+    {
+      const auto h = a[pivot][column];
+      a[pivot][column] = a[best][column];
+      a[best][column] = h;
+    }
+    const auto scale = a[pivot][pivot];
+    for(int column=0; column < 2 * M; ++column)
+    {
+      a[pivot][column] /= scale;
+    }
+    for(int row=0; row < M; ++row)
+    {
+      if(row != pivot)
+      {
+        const auto factor = a[row][pivot];
+        for(int column=0; column < 2 * M; ++column)
+        {
+          a[row][column] -= factor * a[pivot][column];
+        }
+      }
+    }
+  }
+  // Rows of (J^T J)^-1 J^T, times d! for the derivatives
+  std::array<std::array<F, Window>, 3> result{};
+  for(int d=0; d < 3 && d < M; ++d)
+  {
+    for(int k=0; k < Window; ++k)
+    {
+      double sum = 0, power = 1;
+      for(int j=0; j < M; ++j)
+      {
+        sum += a[d][M + j] * power;
+        power *= Lag - k;
+      }
+      result[d][k] = F(sum * (d == 2 ? 2 : 1));
+    }
+  }
+  return result;
+}
+
+template<typename F>
+struct savitzky_golay_t
+{
+  F value;
+  F first_derivative;
+  F second_derivative;
+};
+
+// Streaming Savitzky-Golay smoothing and differentiation. Each
+// result costs three dot products over the window. By default the
+// polynomial is evaluated at the window center, which delays the
+// output by Window / 2 samples; a Lag of 0 evaluates at the newest
+// sample instead, trading noise for latency. Derivatives are per
+// sample_period, as given to the constructor, and zero if the
+// polynomial order is too low to have them.
+template<typename F, int Window, int Order, int Lag=Window / 2>
+class SavitzkyGolayFilter
+{
+public:
+  static_assert(Window > Order, "Window too small for the polynomial order");
+  static_assert(Lag >= 0 && Lag < Window, "Lag must lie within the window");
+  using result_t = savitzky_golay_t<F>;
+
+  static constexpr auto COEFFICIENTS = savitzky_golay_coefficients<F, Window, Order, Lag>();
+
+  SavitzkyGolayFilter(F sample_period=F(1))
+    : _rate(F(1) / sample_period)
+  {}
+
+  std::optional<result_t> update(F value)
+  {
+    // Every sample is stored twice, so the window
+    // is always contiguous.
+    _head = _head == 0 ? Window - 1 : _head - 1;
+    _history[_head] = value;
+    _history[_head + Window] = value;
+    if(++_updates >= Window)
+    {
+      return result_t{
+        convolve(COEFFICIENTS[0]),
+        convolve(COEFFICIENTS[1]) * _rate,
+        convolve(COEFFICIENTS[2]) * _rate * _rate
+      };
+    }
+    return std::nullopt;
+  }
+
+private:
+  F convolve(const std::array<F, Window>& coefficients) const
+  {
+    F result{};
+    const auto* history = &_history[_head];
+    for(int k=0; k < Window; ++k)
+    {
+      result += coefficients[k] * history[k];
+    }
+    return result;
+  }
+
+  F _rate;
+  std::array<F, 2 * Window> _history{};
+  int _head = 0;
+  size_t _updates = 0;
+};
+
+} // namespace deets::filters
@@ -0,0 +1,145 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+namespace deets::statistics {
+
+// A log-linear bucketed histogram in the spirit of HdrHistogram.
+// Values below 2^SubBucketBits get a bucket each, above that every
+// power of two is split into 2^SubBucketBits buckets, so the
+// relative error stays below 2^-SubBucketBits across the whole
+// range up to 2^MaxBits. Larger values are clamped into the last
+// bucket. Memory is fixed, record() is O(1).
+//
+// Histograms aren't synchronized, give each thread its own
+// and merge() them afterwards.
+template<int SubBucketBits=7, int MaxBits=40>
+class Histogram
+{
+public:
+  static_assert(SubBucketBits > 0 && SubBucketBits < MaxBits && MaxBits <= 64, "Invalid bucket layout");
+  static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SubBucketBits;
+  static constexpr size_t BUCKETS = (MaxBits - SubBucketBits + 1) * SUB_BUCKETS;
+  static constexpr uint64_t HIGHEST_TRACKABLE = MaxBits == 64 ? ~uint64_t(0) : (uint64_t(1) << MaxBits) - 1;
+
+  void record(uint64_t value, uint64_t count=1)
+  {
+    value = std::min(value, HIGHEST_TRACKABLE);
+    _counts[index(value)] += count;
+    _total += count;
+    _min = std::min(_min, value);
+    _max = std::max(_max, value);
+    _sum += value * count;
+  }
+
+  void merge(const Histogram& other)
+  {
+    for(size_t i=0; i < BUCKETS; ++i)
+    {
+      _counts[i] += other._counts[i];
+    }
+    _total += other._total;
+    _min = std::min(_min, other._min);
+    _max = std::max(_max, other._max);
+    _sum += other._sum;
+  }
+
+  void reset()
+  {
+    *this = Histogram{};
+  }
+
+  uint64_t total() const { return _total; }
+  uint64_t min() const { return _total ? _min : 0; }
+  uint64_t max() const { return _max; }
+
+  double mean() const
+  {
+    return _total ? double(_sum) / double(_total) : 0.0;
+  }
+
+  // The value that percent of all recorded values are
+  // less than or equal to, up to the bucket resolution.
+  uint64_t percentile(double percent) const
+  {
+    if(_total == 0)
+    {
+      return 0;
+    }
+    const auto wanted = std::max(uint64_t(1), uint64_t(percent / 100.0 * double(_total) + 0.5));
+    uint64_t seen = 0;
+    for(size_t i=0; i < BUCKETS; ++i)
+    {
+      seen += _counts[i];
+      if(seen >= wanted)
+      {
+        return std::min(highest_equivalent(i), _max);
+      }
+    }
+    return _max;
+  }
+
+  uint64_t count_at(uint64_t value) const
+  {
+    return _counts[index(std::min(value, HIGHEST_TRACKABLE))];
+  }
+
+  static size_t index(uint64_t value)
+  {
+    const auto msb = most_significant_bit(value);
+    if(msb < SubBucketBits)
+    {
+      return size_t(value);
+    }
+    const auto shift = msb - SubBucketBits;
+    const auto group = shift + 1;
+    return size_t(group * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+  }
+
+  static uint64_t lowest_equivalent(size_t index)
+  {
+    const auto group = index / SUB_BUCKETS;
+    const auto sub = index % SUB_BUCKETS;
+    if(group == 0)
+    {
+      return sub;
+    }
+    return (SUB_BUCKETS + sub) << (group - 1);
+  }
+
+  static uint64_t highest_equivalent(size_t index)
+  {
+    const auto group = index / SUB_BUCKETS;
+    return lowest_equivalent(index) + (group == 0 ? 0 : (uint64_t(1) << (group - 1)) - 1);
+  }
+
+private:
+  static int most_significant_bit(uint64_t value)
+  {
+    if(value == 0)
+    {
+      return -1;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int result = 0;
+    while(value >>= 1)
+    {
+      ++result;
+    }
+    return result;
+#endif
+  }
+
+  std::array<uint64_t, BUCKETS> _counts{};
+  uint64_t _total = 0;
+  uint64_t _min = ~uint64_t(0);
+  uint64_t _max = 0;
+  uint64_t _sum = 0;
+};
+
+} // namespace deets::statistics
@@ -0,0 +1,106 @@
+// (c) Diez Roggisch, 2023
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace deets::concurrent {
+
+constexpr size_t CACHE_LINE = 64;
+
+// A wait-free ring buffer for exactly one producer and one
+// consumer, e.g. an interrupt handler and the main loop. Head
+// and tail sit on their own cache lines, and each side keeps
+// a cached copy of the other's index, so it only touches the
+// shared line when the ring looks full or empty.
+//
+// A full ring rejects the new element and counts an overrun.
+// Together with the high water mark that shows how big the
+// ring has to be for the worst case consumer latency.
+template<typename T, size_t Capacity>
+class SpscRing
+{
+public:
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+  static constexpr size_t MASK = Capacity - 1;
+
+  // Producer side
+  bool push(const T& value)
+  {
+    const auto head = _head.load(std::memory_order_relaxed);
+    if(head - _tail_cache == Capacity)
+    {
+      _tail_cache = _tail.load(std::memory_order_acquire);
+      if(head - _tail_cache == Capacity)
+      {
+        // Only the producer writes it, no need for an atomic increment
+        _overruns.store(_overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    _values[head & MASK] = value;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T& value)
+  {
+    return pop(&value, 1) == 1;
+  }
+
+  // Pops up to max elements in one go, with a single
+  // acquire and release. Returns how many.
+  size_t pop(T* out, size_t max)
+  {
+    const auto tail = _tail.load(std::memory_order_relaxed);
+    if(_head_cache - tail < max)
+    {
+      _head_cache = _head.load(std::memory_order_acquire);
+      // The backlog peaks right before the consumer gets to it
+      if(_head_cache - tail > _high_water_mark.load(std::memory_order_relaxed))
+      {
+        _high_water_mark.store(_head_cache - tail, std::memory_order_relaxed);
+      }
+    }
+    const auto count = std::min(max, _head_cache - tail);
+    for(size_t i=0; i < count; ++i)
+    {
+      out[i] = _values[(tail + i) & MASK];
+    }
+    _tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  // Only exact when called from one of the two sides
+  size_t size() const
+  {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() { return Capacity; }
+
+  uint32_t overruns() const { return _overruns.load(std::memory_order_relaxed); }
+
+  // The biggest backlog the consumer found, not counting
+  // what was lost to overruns.
+  size_t high_water_mark() const { return _high_water_mark.load(std::memory_order_relaxed); }
+
+private:
+  std::array<T, Capacity> _values{};
+
+  // Written by the producer
+  alignas(CACHE_LINE) std::atomic<size_t> _head{0};
+  size_t _tail_cache = 0;
+  std::atomic<uint32_t> _overruns{0};
+
+  // Written by the consumer
+  alignas(CACHE_LINE) std::atomic<size_t> _tail{0};
+  size_t _head_cache = 0;
+  std::atomic<size_t> _high_water_mark{0};
+};
+
+} // namespace deets::concurrent
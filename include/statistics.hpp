@@ -2,10 +2,18 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 #include <optional>
+#include <cassert>
 #include <algorithm>
 #include <numeric>
 #include <cmath>
 #include <array>
+#include <functional>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
 
 namespace deets::statistics {
 
@@ -31,6 +39,102 @@ T reduce( InputIt first, InputIt last, T init, BinaryOp binary_op )
   return init;
 }
 
+// Summation policies. Each sums transform(x) over a range in a
+// fixed order, so results only depend on the input and not on the
+// platform, as long as the compiler isn't allowed to reassociate
+// floating point math (no -ffast-math).
+
+// Straight accumulation, the fastest, but with float samples
+// around 1000 mbar it loses digits within a few thousand samples.
+struct naive_summation
+{
+  template<typename T, typename InputIt, typename Transform>
+  static T sum(InputIt first, InputIt last, Transform transform)
+  {
+    T accu{};
+    for(;first != last; ++first)
+    {
+      accu += transform(*first);
+    }
+    return accu;
+  }
+};
+
+// Neumaier's variant of Kahan summation, carries the rounding error
+// of each addition in a separate compensation term.
+struct compensated_summation
+{
+  template<typename T, typename InputIt, typename Transform>
+  static T sum(InputIt first, InputIt last, Transform transform)
+  {
+    T accu{}, compensation{};
+    for(;first != last; ++first)
+    {
+      const T value = transform(*first);
+      const T t = accu + value;
+      if(std::abs(accu) >= std::abs(value))
+      {
+        compensation += (accu - t) + value;
+      }
+      else
+      {
+        compensation += (value - t) + accu;
+      }
+      accu = t;
+    }
+    return accu + compensation;
+  }
+};
+
+// Splits the range in halves down to blocks of Block values,
+// which keeps the error growth logarithmic. The blocks are summed
+// in Lanes independent accumulators, which the compiler can map
+// onto SIMD registers without reassociating anything itself.
+// Needs random access iterators.
+template<size_t Block=64, size_t Lanes=8>
+struct pairwise_summation
+{
+  static_assert(Block % Lanes == 0, "Block must be a multiple of Lanes");
+
+  template<typename T, typename InputIt, typename Transform>
+  static T sum(InputIt first, InputIt last, Transform transform)
+  {
+    const auto count = size_t(std::distance(first, last));
+    if(count > Block)
+    {
+      const auto middle = first + count / 2;
+      return sum<T>(first, middle, transform) + sum<T>(middle, last, transform);
+    }
+    std::array<T, Lanes> lanes{};
+    size_t i = 0;
+    for(; i + Lanes <= count; i += Lanes)
+    {
+      for(size_t lane=0; lane < Lanes; ++lane)
+      {
+        lanes[lane] += transform(first[i + lane]);
+      }
+    }
+    for(; i < count; ++i)
+    {
+      lanes[0] += transform(first[i]);
+    }
+    for(size_t width=Lanes / 2; width > 0; width /= 2)
+    {
+      for(size_t lane=0; lane < width; ++lane)
+      {
+        lanes[lane] += lanes[lane + width];
+      }
+    }
+    return lanes[0];
+  }
+};
+
+template <typename InputIt, typename Summation>
+typename std::iterator_traits<InputIt>::value_type reduce(InputIt start, InputIt end, Summation)
+{
+  using T = typename std::iterator_traits<InputIt>::value_type;
+  return Summation::template sum<T>(start, end, [](const T& value) { return value; });
+}
 
 template <typename F>
 struct statistics_t
@@ -71,23 +175,261 @@ struct RollingStatistics
 
   std::optional<result_t> update(F value)
   {
-    std::optional<result_t> result;
+    push(value);
+    return result();
+  }
+
+  // Feeds a whole block, and only reports the final result.
+  template<typename InputIt>
+  std::optional<result_t> update(InputIt first, InputIt last)
+  {
+    for(; first != last; ++first)
+    {
+      push(*first);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    // We  only report back if we've done this long enough
+    if(updates >= Confidence)
+    {
+      return result_t{ average, variance };
+    }
+    return std::nullopt;
+  }
+
+private:
+  void push(F value)
+  {
     ++updates;
     const auto oldavg = average;
     const auto newavg = oldavg + (value - previous) / n;
     average = newavg;
     variance += (value - previous) * (value - newavg + previous - oldavg) / (n - 1.0);
-    // We  only report back if we've done this long enough
-    if(updates >= Confidence)
+    previous = value;
+  }
+};
+
+// RollingStatistics with the window length and confidence chosen
+// at runtime. It keeps no samples, so there's nothing to allocate.
+template <typename F>
+struct DynamicRollingStatistics
+{
+  using result_t = statistics_t<F>;
+
+  DynamicRollingStatistics(size_t size, F average_, F variance_)
+    : DynamicRollingStatistics(size, size, average_, variance_)
+  {
+  }
+
+  DynamicRollingStatistics(size_t size, size_t confidence_, F average_, F variance_)
+    : n(F(size))
+    , confidence(confidence_)
+    , average(average_)
+    , variance(variance_)
+    , previous(average_)
+  {
+  }
+
+  F n;
+  size_t confidence;
+  F average;
+  F variance;
+  F previous;
+  size_t updates = 0;
+
+  std::optional<result_t> update(F value)
+  {
+    push(value);
+    return result();
+  }
+
+  template<typename InputIt>
+  std::optional<result_t> update(InputIt first, InputIt last)
+  {
+    for(; first != last; ++first)
+    {
+      push(*first);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates >= confidence)
     {
-      result = { average, variance };
+      return result_t{ average, variance };
     }
+    return std::nullopt;
+  }
+
+private:
+  void push(F value)
+  {
+    ++updates;
+    const auto oldavg = average;
+    const auto newavg = oldavg + (value - previous) / n;
+    average = newavg;
+    variance += (value - previous) * (value - newavg + previous - oldavg) / (n - 1.0);
     previous = value;
-    return result;
   }
 };
 
-template<typename F, int N>
+// Exponentially weighted moving average and variance. The
+// smoothing factor Alpha is a std::ratio, so the weights are
+// compile time constants. No sample buffer is needed.
+template <typename F, typename Alpha, int Confidence=1>
+struct ExponentialStatistics
+{
+  static_assert(Alpha::num > 0 && Alpha::num <= Alpha::den, "Alpha must be in (0, 1]");
+  static constexpr F alpha = F(Alpha::num) / F(Alpha::den);
+  static constexpr F decay = F(1) - alpha;
+  using result_t = statistics_t<F>;
+
+  ExponentialStatistics(F average_, F variance_)
+    : average(average_)
+    , variance(variance_)
+  {
+  }
+
+  F average;
+  F variance;
+  size_t updates = 0;
+
+  std::optional<result_t> update(F value)
+  {
+    push(value);
+    return result();
+  }
+
+  template<typename InputIt>
+  std::optional<result_t> update(InputIt first, InputIt last)
+  {
+    for(; first != last; ++first)
+    {
+      push(*first);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates >= Confidence)
+    {
+      return result_t{ average, variance };
+    }
+    return std::nullopt;
+  }
+
+private:
+  void push(F value)
+  {
+    ++updates;
+    const auto diff = value - average;
+    const auto increment = alpha * diff;
+    average += increment;
+    variance = decay * (variance + diff * increment);
+  }
+};
+
+// The same as ExponentialStatistics, but for irregularly
+// spaced samples. The smoothing factor is derived from the
+// elapsed time since the last sample and the time constant
+// tau as elapsed / (tau + elapsed).
+template <typename F, typename Duration, int Confidence=1>
+struct TimedExponentialStatistics
+{
+  using result_t = statistics_t<F>;
+
+  TimedExponentialStatistics(Duration tau_, F average_, F variance_)
+    : tau(tau_)
+    , average(average_)
+    , variance(variance_)
+  {
+  }
+
+  Duration tau;
+  F average;
+  F variance;
+  size_t updates = 0;
+
+  std::optional<result_t> update(F value, Duration elapsed)
+  {
+    push(value, elapsed);
+    return result();
+  }
+
+  // Feeds a block of values, each with the time
+  // elapsed since its predecessor.
+  template<typename InputIt, typename DurationIt>
+  std::optional<result_t> update(InputIt first, InputIt last, DurationIt elapsed)
+  {
+    for(; first != last; ++first, ++elapsed)
+    {
+      push(*first, *elapsed);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates >= Confidence)
+    {
+      return result_t{ average, variance };
+    }
+    return std::nullopt;
+  }
+
+private:
+  void push(F value, Duration elapsed)
+  {
+    ++updates;
+    const auto alpha = F(elapsed.count()) / F((tau + elapsed).count());
+    const auto diff = value - average;
+    const auto increment = alpha * diff;
+    average += increment;
+    variance = (F(1) - alpha) * (variance + diff * increment);
+  }
+};
+
+// Mean and sample variance of a filled window.
+template<typename F, typename Summation, typename InputIt>
+statistics_t<F> window_statistics(InputIt first, InputIt last)
+{
+  const auto n = F(std::distance(first, last));
+  const auto average = statistics::reduce(first, last, Summation{}) / n;
+  // Two passes, so we only sum up the (small) squared
+  // deviations and don't subtract nearly equal sums. They
+  // accumulate in double, as they always did.
+  const F variance = F(Summation::template sum<double>(
+    first, last,
+    [average](const F& current)
+    {
+      const double deviation = average - current;
+      return deviation * deviation;
+    }
+    ) / (n - 1)); // Not sure exactly why, but that's the python version
+  return statistics_t<F>{ average, variance };
+}
+
+// Stores a block into a window kept as a ring, which is
+// continued at updates % size. Wrapping the index instead
+// of a modulo per value.
+template<typename Values, typename InputIt>
+void store_window(Values& values, size_t& updates, InputIt first, InputIt last)
+{
+  const auto size = values.size();
+  auto index = updates % size;
+  for(; first != last; ++first, ++updates)
+  {
+    values[index] = *first;
+    index = index + 1 == size ? 0 : index + 1;
+  }
+}
+
+template<typename F, int N, typename Summation=naive_summation>
 struct ArrayStatistics
 {
   using result_t = statistics_t<F>;
@@ -99,19 +441,23 @@ struct ArrayStatistics
   std::optional<result_t> update(F value)
   {
     values[updates++ % N] = value;
+    return result();
+  }
+
+  // Only the last N values of a block matter, so they are
+  // just stored, and the statistics computed once.
+  template<typename InputIt>
+  std::optional<result_t> update(InputIt first, InputIt last)
+  {
+    store_window(values, updates, first, last);
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
     if(updates >= N)
     {
-      const auto average = reduce(
-        values.begin(), values.end()
-        ) / n;
-      const F variance = reduce(
-        values.begin(), values.end(),
-        0.0, [average](const F& previous, const F& current)
-        {
-          return previous + std::pow(average - current, 2);
-        }
-        ) / (n - 1); // Not sure exactly why, but that's the python version
-      return result_t{ average, variance };
+      return window_statistics<F, Summation>(values.begin(), values.end());
     }
     return std::nullopt;
   }
@@ -127,4 +473,816 @@ struct ArrayStatistics
   }
 };
 
+// ArrayStatistics with the window length chosen at runtime. The
+// values come from the given memory resource, so many windows can
+// share one monotonic_buffer_resource over a single block instead
+// of each going to the heap.
+template<typename F, typename Summation=naive_summation>
+struct DynamicArrayStatistics
+{
+  using result_t = statistics_t<F>;
+
+  DynamicArrayStatistics(size_t size, std::pmr::memory_resource* resource=std::pmr::get_default_resource())
+    : values(size, F{}, resource)
+  {
+    assert(size > 0);
+  }
+
+  std::pmr::vector<F> values;
+  size_t updates = 0;
+
+  std::optional<result_t> update(F value)
+  {
+    values[updates++ % values.size()] = value;
+    return result();
+  }
+
+  template<typename InputIt>
+  std::optional<result_t> update(InputIt first, InputIt last)
+  {
+    store_window(values, updates, first, last);
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates >= values.size())
+    {
+      return window_statistics<F, Summation>(values.begin(), values.end());
+    }
+    return std::nullopt;
+  }
+
+  std::optional<F> median()
+  {
+    if(updates >= values.size())
+    {
+      std::sort(values.begin(), values.end());
+      return values[values.size() / 2];
+    }
+    return std::nullopt;
+  }
+};
+
+// Tracks the extremum of the last N values using a monotonic
+// deque kept in fixed ring buffers, so each update is amortized
+// O(1) and never allocates. Compare decides which value wins,
+// std::less yields the minimum.
+template<typename F, int N, typename Compare=std::less<F>>
+struct SlidingExtremum
+{
+  std::array<F, N> values;
+  std::array<size_t, N> indices;
+  size_t head = 0;
+  size_t size = 0;
+  size_t updates = 0;
+
+  std::optional<F> update(F value)
+  {
+    push(value);
+    if(updates >= N)
+    {
+      return values[head];
+    }
+    return std::nullopt;
+  }
+
+  template<typename InputIt>
+  std::optional<F> update(InputIt first, InputIt last)
+  {
+    for(; first != last; ++first)
+    {
+      push(*first);
+    }
+    if(updates >= N)
+    {
+      return values[head];
+    }
+    return std::nullopt;
+  }
+
+  F extremum() const
+  {
+    return values[head];
+  }
+
+private:
+  void push(F value)
+  {
+    // Drop the front once it left the window
+    if(size && indices[head] + N <= updates)
+    {
+      head = wrap(head + 1);
+      --size;
+    }
+    // Everything at the back that can't win against
+    // the new value anymore is useless
+    while(size && !Compare{}(values[wrap(head + size - 1)], value))
+    {
+      --size;
+    }
+    const auto tail = wrap(head + size);
+    values[tail] = value;
+    indices[tail] = updates++;
+    ++size;
+  }
+
+  static size_t wrap(size_t index)
+  {
+    return index >= N ? index - N : index;
+  }
+};
+
+// Integer square root, rounded down. Works
+// bit by bit, so it needs no FPU.
+template<typename T>
+constexpr T isqrt(T value)
+{
+  T result = 0;
+  T bit = T(1) << ((std::numeric_limits<T>::digits - 1) & ~1);
+  while(bit > value)
+  {
+    bit >>= 2;
+  }
+  while(bit)
+  {
+    if(value >= result + bit)
+    {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    }
+    else
+    {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return result;
+}
+
+// Describes a Q-format fixed point number with FractionalBits
+// behind the binary point. The statistics below work on the raw
+// representation directly, their averages are in the same format,
+// variances have twice the fractional bits.
+template<int FractionalBits, typename Rep=int32_t>
+struct q_format
+{
+  using rep_t = Rep;
+  static constexpr int fractional_bits = FractionalBits;
+  static constexpr Rep one = Rep(1) << FractionalBits;
+
+  static constexpr Rep from(double value)
+  {
+    return Rep(value * one + (value < 0 ? -0.5 : 0.5));
+  }
+
+  static constexpr double to(Rep value)
+  {
+    return double(value) / one;
+  }
+
+  static constexpr double to_variance(int64_t value)
+  {
+    return double(value) / (double(one) * double(one));
+  }
+};
+
+template <typename T, typename Accumulator>
+struct integer_statistics_t
+{
+  T average;
+  Accumulator variance;
+
+  T stddev() const
+  {
+    return T(isqrt(variance));
+  }
+};
+
+// The integer sibling of ArrayStatistics. Sums are kept exact in a
+// wide accumulator relative to the first sample, so every update is
+// O(1) and results are bit-identical on any target. Divisions by a
+// power of two N become shifts (rounding towards negative infinity).
+// The accumulator must hold N * N times the largest squared deviation
+// from the first sample.
+template<typename T, int N, typename Accumulator=int64_t>
+struct IntegerArrayStatistics
+{
+  static_assert(std::is_integral<T>::value, "Use ArrayStatistics for floating point");
+  static_assert(std::is_signed<Accumulator>::value, "Deviations need a signed accumulator");
+  static_assert(N >= 2, "Need at least two samples for a variance");
+  using result_t = integer_statistics_t<T, Accumulator>;
+
+  std::array<T, N> values;
+  size_t updates = 0;
+
+  std::optional<result_t> update(T value)
+  {
+    push(value);
+    return result();
+  }
+
+  template<typename InputIt>
+  std::optional<result_t> update(InputIt first, InputIt last)
+  {
+    for(; first != last; ++first)
+    {
+      push(*first);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates >= N)
+    {
+      const auto spread = multiply_n(sum_of_squares) - sum * sum;
+      return result_t{
+        T(offset + divide_n(sum)),
+        divide_n(spread) / (N - 1)
+      };
+    }
+    return std::nullopt;
+  }
+
+private:
+  void push(T value)
+  {
+    if(updates == 0)
+    {
+      offset = value;
+    }
+    const auto index = updates++ % N;
+    if(updates > N)
+    {
+      const auto old = Accumulator(values[index]) - offset;
+      sum -= old;
+      sum_of_squares -= old * old;
+    }
+    values[index] = value;
+    const auto deviation = Accumulator(value) - offset;
+    sum += deviation;
+    sum_of_squares += deviation * deviation;
+  }
+
+  static constexpr bool power_of_two = (N & (N - 1)) == 0;
+
+  static constexpr int log2_n()
+  {
+    int result = 0;
+    while((1 << result) < N)
+    {
+      ++result;
+    }
+    return result;
+  }
+
+  static Accumulator divide_n(Accumulator value)
+  {
+    if constexpr (power_of_two)
+    {
+      return value >> log2_n();
+    }
+    else
+    {
+      return value / N;
+    }
+  }
+
+  static Accumulator multiply_n(Accumulator value)
+  {
+    if constexpr (power_of_two)
+    {
+      return value << log2_n();
+    }
+    else
+    {
+      return value * N;
+    }
+  }
+
+  Accumulator offset = 0;
+  Accumulator sum = 0;
+  Accumulator sum_of_squares = 0;
+};
+
+// Median of the last N values. Besides the ring of values in
+// arrival order, a sorted copy is maintained by moving the
+// replacement into place, so an update costs at most N moves and
+// nothing is allocated.
+template<typename F, int N>
+struct SlidingMedian
+{
+  std::array<F, N> values;
+  std::array<F, N> sorted;
+  size_t updates = 0;
+
+  std::optional<F> update(F value)
+  {
+    push(value);
+    if(updates >= N)
+    {
+      return median();
+    }
+    return std::nullopt;
+  }
+
+  template<typename InputIt>
+  std::optional<F> update(InputIt first, InputIt last)
+  {
+    for(; first != last; ++first)
+    {
+      push(*first);
+    }
+    if(updates >= N)
+    {
+      return median();
+    }
+    return std::nullopt;
+  }
+
+  F median() const
+  {
+    return sorted[size() / 2];
+  }
+
+  // Median absolute deviation from the median. The deviations
+  // above and below the median are both sorted already, so
+  // walking them like a merge finds it in N / 2 steps.
+  F mad() const
+  {
+    const auto count = size();
+    const auto middle = count / 2;
+    const auto m = sorted[middle];
+    size_t below = middle, above = middle;
+    F deviation{};
+    for(size_t i=0; i <= middle; ++i)
+    {
+      if(above < count && (below == 0 || sorted[above] - m <= m - sorted[below - 1]))
+      {
+        deviation = sorted[above++] - m;
+      }
+      else
+      {
+        deviation = m - sorted[--below];
+      }
+    }
+    return deviation;
+  }
+
+  size_t size() const
+  {
+    return std::min(updates, size_t(N));
+  }
+
+private:
+  void push(F value)
+  {
+    const auto index = updates % N;
+    size_t pos;
+    if(updates < N)
+    {
+      pos = updates;
+    }
+    else
+    {
+      pos = std::lower_bound(sorted.begin(), sorted.end(), values[index]) - sorted.begin();
+    }
+    values[index] = value;
+    ++updates;
+    const auto count = size();
+    sorted[pos] = value;
+    for(; pos > 0 && value < sorted[pos - 1]; --pos)
+    {
+      std::swap(sorted[pos], sorted[pos - 1]);
+    }
+    for(; pos + 1 < count && sorted[pos + 1] < value; ++pos)
+    {
+      std::swap(sorted[pos], sorted[pos + 1]);
+    }
+  }
+};
+
+template <typename F>
+struct linear_fit_t
+{
+  F slope;
+  F intercept;
+
+  F operator()(F x) const
+  {
+    return slope * x + intercept;
+  }
+};
+
+// Least squares line through the last N (x, y) samples. The
+// running sums are kept relative to the window mean, and are
+// recomputed from the buffer once per window so neither large
+// offsets nor the subtraction of evicted samples erode float
+// precision over long runs.
+template <typename F, int N>
+struct RollingRegression
+{
+  static_assert(N >= 2, "Need at least two samples for a line");
+  using result_t = linear_fit_t<F>;
+  static constexpr F n = F(N);
+
+  std::array<F, N> xs;
+  std::array<F, N> ys;
+  size_t updates = 0;
+
+  std::optional<result_t> update(F x, F y)
+  {
+    push(x, y);
+    return result();
+  }
+
+  // Feeds a block of x values, and their y values
+  // starting at y_first.
+  template<typename InputIt, typename OtherIt>
+  std::optional<result_t> update(InputIt x_first, InputIt x_last, OtherIt y_first)
+  {
+    for(; x_first != x_last; ++x_first, ++y_first)
+    {
+      push(*x_first, *y_first);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates >= N)
+    {
+      const auto sxx = sum_xx - sum_x * sum_x / n;
+      const auto sxy = sum_xy - sum_x * sum_y / n;
+      const auto slope = sxy / sxx;
+      return result_t{
+        slope,
+        y0 + sum_y / n - slope * (x0 + sum_x / n)
+      };
+    }
+    return std::nullopt;
+  }
+
+private:
+  void push(F x, F y)
+  {
+    const auto index = updates++ % N;
+    if(updates > N)
+    {
+      evict(xs[index] - x0, ys[index] - y0);
+    }
+    xs[index] = x;
+    ys[index] = y;
+    if(updates == 1)
+    {
+      x0 = x;
+      y0 = y;
+    }
+    if(index == N - 1)
+    {
+      recenter();
+    }
+    else
+    {
+      add(x - x0, y - y0);
+    }
+  }
+
+  void add(F dx, F dy)
+  {
+    sum_x += dx;
+    sum_y += dy;
+    sum_xx += dx * dx;
+    sum_xy += dx * dy;
+  }
+
+  void evict(F dx, F dy)
+  {
+    sum_x -= dx;
+    sum_y -= dy;
+    sum_xx -= dx * dx;
+    sum_xy -= dx * dy;
+  }
+
+  // Moves the origin to the mean of the samples held and
+  // rebuilds the sums from scratch.
+  void recenter()
+  {
+    const auto count = std::min(updates, size_t(N));
+    x0 = reduce(xs.begin(), xs.begin() + count) / F(count);
+    y0 = reduce(ys.begin(), ys.begin() + count) / F(count);
+    sum_x = sum_y = sum_xx = sum_xy = F{};
+    for(size_t i=0; i < count; ++i)
+    {
+      add(xs[i] - x0, ys[i] - y0);
+    }
+  }
+
+  F x0{}, y0{};
+  F sum_x{}, sum_y{}, sum_xx{}, sum_xy{};
+};
+
+// y = a + b * (x - origin) + c * (x - origin)^2. The origin is
+// the window center, large x offsets would otherwise swamp the
+// coefficients in float.
+template <typename F>
+struct quadratic_fit_t
+{
+  F origin;
+  F a;
+  F b;
+  F c;
+  // Residual sums of squares of the best line and parabola
+  F linear_residual;
+  F residual;
+  // How much the quadratic term explains beyond the line,
+  // compare against the F(1, N - 3) distribution.
+  F f_statistic;
+
+  F operator()(F x) const
+  {
+    const auto dx = x - origin;
+    return a + (b + c * dx) * dx;
+  }
+
+  F second_derivative() const
+  {
+    return 2 * c;
+  }
+};
+
+// Least squares parabola through the last N (x, y) samples. Like
+// RollingRegression, the power sums are kept relative to the
+// window mean and rebuilt once per window. Each update is O(1),
+// the 3x3 normal equations are solved in closed form.
+template <typename F, int N>
+struct RollingQuadraticFit
+{
+  static_assert(N >= 4, "Need more samples than coefficients");
+  using result_t = quadratic_fit_t<F>;
+  static constexpr F n = F(N);
+
+  std::array<F, N> xs;
+  std::array<F, N> ys;
+  size_t updates = 0;
+
+  std::optional<result_t> update(F x, F y)
+  {
+    push(x, y);
+    return result();
+  }
+
+  template<typename InputIt, typename OtherIt>
+  std::optional<result_t> update(InputIt x_first, InputIt x_last, OtherIt y_first)
+  {
+    for(; x_first != x_last; ++x_first, ++y_first)
+    {
+      push(*x_first, *y_first);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates < N)
+    {
+      return std::nullopt;
+    }
+    // Cofactors of the symmetric moment matrix
+    // [[n, x, x2], [x, x2, x3], [x2, x3, x4]]
+    const auto c00 = sum_x2 * sum_x4 - sum_x3 * sum_x3;
+    const auto c01 = sum_x2 * sum_x3 - sum_x * sum_x4;
+    const auto c02 = sum_x * sum_x3 - sum_x2 * sum_x2;
+    const auto c11 = n * sum_x4 - sum_x2 * sum_x2;
+    const auto c12 = sum_x * sum_x2 - n * sum_x3;
+    const auto c22 = n * sum_x2 - sum_x * sum_x;
+    const auto det = n * c00 + sum_x * c01 + sum_x2 * c02;
+    const auto a = (c00 * sum_y + c01 * sum_xy + c02 * sum_x2y) / det;
+    const auto b = (c01 * sum_y + c11 * sum_xy + c12 * sum_x2y) / det;
+    const auto c = (c02 * sum_y + c12 * sum_xy + c22 * sum_x2y) / det;
+
+    const auto sxx = sum_x2 - sum_x * sum_x / n;
+    const auto sxy = sum_xy - sum_x * sum_y / n;
+    const auto syy = sum_y2 - sum_y * sum_y / n;
+    // Rounding can make these slightly negative for perfect fits
+    const auto linear_residual = std::max(F{}, syy - sxy * sxy / sxx);
+    const auto residual = std::max(F{}, sum_y2 - (a * sum_y + b * sum_xy + c * sum_x2y));
+    const auto explained = std::max(F{}, linear_residual - residual);
+    const auto f_statistic = residual > F{}
+      ? explained / (residual / (n - 3))
+      : std::numeric_limits<F>::max();
+
+    // Move a and the derivative to the window center
+    const auto center = sum_x / n;
+    return result_t{
+      x0 + center,
+      y0 + a + (b + c * center) * center,
+      b + 2 * c * center,
+      c,
+      linear_residual,
+      residual,
+      f_statistic
+    };
+  }
+
+private:
+  void push(F x, F y)
+  {
+    const auto index = updates++ % N;
+    if(updates > N)
+    {
+      accumulate(xs[index] - x0, ys[index] - y0, F(-1));
+    }
+    xs[index] = x;
+    ys[index] = y;
+    if(updates == 1)
+    {
+      x0 = x;
+      y0 = y;
+    }
+    if(index == N - 1)
+    {
+      recenter();
+    }
+    else
+    {
+      accumulate(x - x0, y - y0, F(1));
+    }
+  }
+
+  void accumulate(F dx, F dy, F sign)
+  {
+    const auto dx2 = dx * dx;
+    sum_x += sign * dx;
+    sum_x2 += sign * dx2;
+    sum_x3 += sign * dx2 * dx;
+    sum_x4 += sign * dx2 * dx2;
+    sum_y += sign * dy;
+    sum_y2 += sign * dy * dy;
+    sum_xy += sign * dx * dy;
+    sum_x2y += sign * dx2 * dy;
+  }
+
+  void recenter()
+  {
+    const auto count = std::min(updates, size_t(N));
+    x0 = reduce(xs.begin(), xs.begin() + count) / F(count);
+    y0 = reduce(ys.begin(), ys.begin() + count) / F(count);
+    sum_x = sum_x2 = sum_x3 = sum_x4 = sum_y = sum_y2 = sum_xy = sum_x2y = F{};
+    for(size_t i=0; i < count; ++i)
+    {
+      accumulate(xs[i] - x0, ys[i] - y0, F(1));
+    }
+  }
+
+  F x0{}, y0{};
+  F sum_x{}, sum_x2{}, sum_x3{}, sum_x4{};
+  F sum_y{}, sum_y2{}, sum_xy{}, sum_x2y{};
+};
+
+// Averages and covariance matrix of K channels. The covariance
+// is stored row-major and contiguous, so it can be wrapped in an
+// Eigen::Map<const Eigen::Matrix<F, K, K, Eigen::RowMajor>> without
+// copying.
+template <typename F, int K>
+struct multivariate_statistics_t
+{
+  std::array<F, K> average;
+  std::array<F, K * K> covariance;
+
+  F variance(int channel) const
+  {
+    return covariance[channel * K + channel];
+  }
+
+  F correlation(int a, int b) const
+  {
+    return covariance[a * K + b] / std::sqrt(variance(a) * variance(b));
+  }
+};
+
+// Rolling means and covariances of K channels over the last N
+// samples. Samples are stored per channel (structure of arrays),
+// and all K * K cross products are updated in one flat loop the
+// compiler can vectorize. Like RollingRegression, the sums are
+// kept relative to the window mean and rebuilt once per window.
+// Samples can be anything indexable, like std::array or a
+// fixed-size Eigen vector.
+template<typename F, int K, int N>
+struct RollingMultivariateStatistics
+{
+  static_assert(N >= 2, "Need at least two samples for a covariance");
+  using result_t = multivariate_statistics_t<F, K>;
+  static constexpr F n = F(N);
+
+  std::array<std::array<F, N>, K> values;
+  size_t updates = 0;
+
+  template<typename Vector>
+  std::optional<result_t> update(const Vector& sample)
+  {
+    push(sample);
+    return result();
+  }
+
+  // Feeds a block of samples
+  template<typename InputIt>
+  std::optional<result_t> update(InputIt first, InputIt last)
+  {
+    for(; first != last; ++first)
+    {
+      push(*first);
+    }
+    return result();
+  }
+
+  std::optional<result_t> result() const
+  {
+    if(updates >= N)
+    {
+      result_t result;
+      for(int i=0; i < K; ++i)
+      {
+        result.average[i] = offsets[i] + sums[i] / n;
+        for(int j=0; j < K; ++j)
+        {
+          result.covariance[i * K + j] = (cross[i * K + j] - sums[i] * sums[j] / n) / (n - 1);
+        }
+      }
+      return result;
+    }
+    return std::nullopt;
+  }
+
+private:
+  template<typename Vector>
+  void push(const Vector& sample)
+  {
+    const auto index = updates++ % N;
+    std::array<F, K> current, old{};
+    for(int k=0; k < K; ++k)
+    {
+      if(updates == 1)
+      {
+        offsets[k] = sample[k];
+      }
+      if(updates > N)
+      {
+        old[k] = values[k][index] - offsets[k];
+      }
+      values[k][index] = sample[k];
+      current[k] = sample[k] - offsets[k];
+    }
+    if(index == N - 1)
+    {
+      recenter();
+    }
+    else
+    {
+      for(int i=0; i < K; ++i)
+      {
+        sums[i] += current[i] - old[i];
+        for(int j=0; j < K; ++j)
+        {
+          cross[i * K + j] += current[i] * current[j] - old[i] * old[j];
+        }
+      }
+    }
+  }
+
+  void recenter()
+  {
+    const auto count = std::min(updates, size_t(N));
+    for(int k=0; k < K; ++k)
+    {
+      offsets[k] = reduce(values[k].begin(), values[k].begin() + count) / F(count);
+    }
+    sums.fill(F{});
+    cross.fill(F{});
+    for(size_t s=0; s < count; ++s)
+    {
+      for(int i=0; i < K; ++i)
+      {
+        const auto deviation = values[i][s] - offsets[i];
+        sums[i] += deviation;
+        for(int j=0; j < K; ++j)
+        {
+          cross[i * K + j] += deviation * (values[j][s] - offsets[j]);
+        }
+      }
+    }
+  }
+
+  std::array<F, K> offsets{};
+  std::array<F, K> sums{};
+  std::array<F, K * K> cross{};
+};
+
+template<typename F, int N>
+using SlidingMinimum = SlidingExtremum<F, N, std::less<F>>;
+
+template<typename F, int N>
+using SlidingMaximum = SlidingExtremum<F, N, std::greater<F>>;
+
 } // namespace deets::statistics
@@ -0,0 +1,118 @@
+#include "binary-log.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace deets::log;
+
+namespace {
+
+enum class message : uint16_t
+{
+  HELLO,
+  VALUES,
+};
+
+} // namespace
+
+TEST_CASE("Binary log", "[log]")
+{
+  using test_t = BinaryLog<message, level::INFO, 4>;
+  test_t log;
+  test_t::record_type record;
+
+  SECTION("Levels below the minimum are compiled out")
+  {
+    log.debug(message::HELLO);
+    log.trace(message::HELLO);
+    REQUIRE(log.size() == 0);
+    log.info(message::HELLO);
+    log.error(message::HELLO);
+    REQUIRE(log.size() == 2);
+  }
+
+  SECTION("A disabled log records nothing")
+  {
+    BinaryLog<message, level::OFF, 4> off;
+    off.error(message::HELLO, 1.0f);
+    REQUIRE(off.size() == 0);
+    REQUIRE_FALSE(off.pop(record));
+    REQUIRE(std::is_empty_v<decltype(off)>);
+  }
+
+  SECTION("Records keep their arguments and order")
+  {
+    log.info(message::VALUES, 1.5f, 2, 3.0);
+    log.warning(message::HELLO);
+    REQUIRE(log.pop(record));
+    REQUIRE(record.sequence == 0);
+    REQUIRE(record.message == uint16_t(message::VALUES));
+    REQUIRE(record.severity == level::INFO);
+    REQUIRE(record.argc == 3);
+    REQUIRE(record.args[0] == 1.5f);
+    REQUIRE(record.args[1] == 2.0f);
+    REQUIRE(record.args[2] == 3.0f);
+    REQUIRE(log.pop(record));
+    REQUIRE(record.sequence == 1);
+    REQUIRE(record.argc == 0);
+    REQUIRE_FALSE(log.pop(record));
+  }
+
+  SECTION("A full ring drops and counts new records")
+  {
+    for(int i=0; i < 6; ++i)
+    {
+      log.info(message::VALUES, i);
+    }
+    REQUIRE(log.size() == 4);
+    REQUIRE(log.dropped() == 2);
+    std::vector<float> seen;
+    REQUIRE(log.drain([&seen](const test_t::record_type& r) { seen.push_back(r.args[0]); }) == 4);
+    REQUIRE(seen == std::vector<float>{0, 1, 2, 3});
+    log.info(message::VALUES, 6);
+    REQUIRE(log.pop(record));
+    // The gap in the sequence shows the drop
+    REQUIRE(record.sequence == 6);
+  }
+
+  SECTION("Records are rendered with their format")
+  {
+    log.info(message::VALUES, 1.5f, 2);
+    REQUIRE(log.pop(record));
+    REQUIRE(render(record, "a {} and {}, but not {}") == "a 1.5 and 2, but not {}");
+  }
+
+  SECTION("Producer and consumer can run on different threads")
+  {
+    BinaryLog<message, level::TRACE, 64> shared;
+    constexpr int COUNT = 100000;
+    std::thread producer([&shared]()
+    {
+      for(int i=0; i < COUNT; ++i)
+      {
+        shared.info(message::VALUES, i);
+      }
+    });
+    uint32_t last_sequence = 0;
+    size_t received = 0;
+    bool ordered = true;
+    while(received + shared.dropped() < COUNT || shared.size())
+    {
+      shared.drain([&](const decltype(shared)::record_type& r)
+      {
+        ordered = ordered && (received == 0 || r.sequence > last_sequence);
+        ordered = ordered && r.args[0] == float(r.sequence);
+        last_sequence = r.sequence;
+        ++received;
+      });
+      std::this_thread::yield();
+    }
+    producer.join();
+    shared.drain([&](const decltype(shared)::record_type&) { ++received; });
+    REQUIRE(ordered);
+    REQUIRE(received + shared.dropped() == COUNT);
+  }
+}
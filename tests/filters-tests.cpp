@@ -0,0 +1,308 @@
+#include "filters.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <complex>
+#include <cmath>
+#include <vector>
+#include <iterator>
+
+using namespace deets::filters;
+
+TEST_CASE("Hampel filter", "[filters]")
+{
+  using test_t = HampelFilter<float, 5>;
+  test_t filter;
+
+  SECTION("Samples pass until the window is filled")
+  {
+    for(auto i=0; i < 4; ++i)
+    {
+      REQUIRE(filter.filter(i == 2 ? 100.0f : 1.0f) == (i == 2 ? 100.0f : 1.0f));
+    }
+  }
+
+  SECTION("A single spike is replaced by the median")
+  {
+    const float values[] = { 10.0, 10.2, 9.9, 10.1, 10.0, 50.0, 10.1, 9.8 };
+    for(const auto value : values)
+    {
+      const auto filtered = filter.filter(value);
+      REQUIRE(filtered < 11.0f);
+    }
+    REQUIRE(filter.replaced() == 1);
+  }
+
+  SECTION("A ramp passes unchanged")
+  {
+    for(auto i=0; i < 50; ++i)
+    {
+      REQUIRE(filter.filter(i * 0.5f) == i * 0.5f);
+    }
+    REQUIRE(filter.replaced() == 0);
+  }
+
+  SECTION("The minimal deviation is accepted on a flat signal")
+  {
+    test_t tolerant{3.0, 0.5};
+    for(auto i=0; i < 10; ++i)
+    {
+      tolerant.filter(1000.0f);
+    }
+    REQUIRE(tolerant.filter(1000.4f) == 1000.4f);
+    REQUIRE(tolerant.filter(1002.0f) == 1000.0f);
+  }
+}
+
+namespace {
+
+template<typename F, size_t Sections>
+double magnitude(const std::array<biquad_coefficients_t<F>, Sections>& cascade, double frequency, double sample_rate)
+{
+  const auto z = std::polar(1.0, -2 * M_PI * frequency / sample_rate);
+  std::complex<double> response = 1.0;
+  for(const auto& c : cascade)
+  {
+    response *= (double(c.b0) + double(c.b1) * z + double(c.b2) * z * z)
+      / (1.0 + double(c.a1) * z + double(c.a2) * z * z);
+  }
+  return std::abs(response);
+}
+
+} // namespace
+
+TEST_CASE("Constexpr math", "[filters]")
+{
+  for(double x=-10.0; x < 10.0; x += 0.37)
+  {
+    REQUIRE(deets::cmath::sin(x) == Catch::Approx(std::sin(x)).margin(1e-12));
+    REQUIRE(deets::cmath::cos(x) == Catch::Approx(std::cos(x)).margin(1e-12));
+    REQUIRE(deets::cmath::sqrt(std::abs(x)) == Catch::Approx(std::sqrt(std::abs(x))));
+    REQUIRE(deets::cmath::exp(x) == Catch::Approx(std::exp(x)).epsilon(1e-13));
+  }
+  for(double x=0.01; x < 100.0; x *= 1.37)
+  {
+    REQUIRE(deets::cmath::log(x) == Catch::Approx(std::log(x)).margin(1e-13));
+    REQUIRE(deets::cmath::pow(x, 0.190263) == Catch::Approx(std::pow(x, 0.190263)).epsilon(1e-13));
+  }
+}
+
+TEST_CASE("Butterworth design", "[filters]")
+{
+  constexpr auto lowpass = butterworth_lowpass<double, 2>(4.0, 100.0);
+  constexpr auto highpass = butterworth_highpass<double, 1>(4.0, 100.0);
+
+  SECTION("Lowpass passes DC and has -3dB at the cutoff")
+  {
+    REQUIRE(magnitude(lowpass, 0.0, 100.0) == Catch::Approx(1.0));
+    REQUIRE(magnitude(lowpass, 4.0, 100.0) == Catch::Approx(std::sqrt(0.5)));
+    REQUIRE(magnitude(lowpass, 50.0, 100.0) == Catch::Approx(0.0).margin(1e-9));
+  }
+
+  SECTION("Fourth order lowpass is maximally flat and rolls off steeply")
+  {
+    REQUIRE(magnitude(lowpass, 1.0, 100.0) == Catch::Approx(1.0).epsilon(1e-3));
+    REQUIRE(magnitude(lowpass, 16.0, 100.0) < 0.01);
+  }
+
+  SECTION("Highpass blocks DC")
+  {
+    REQUIRE(magnitude(highpass, 0.0, 100.0) == Catch::Approx(0.0).margin(1e-12));
+    REQUIRE(magnitude(highpass, 4.0, 100.0) == Catch::Approx(std::sqrt(0.5)));
+    REQUIRE(magnitude(highpass, 50.0, 100.0) == Catch::Approx(1.0));
+  }
+}
+
+TEST_CASE("Biquad cascade", "[filters]")
+{
+  constexpr auto coefficients = butterworth_lowpass<float, 2>(4.0, 100.0);
+  BiquadCascade<float, 2> filter{coefficients};
+
+  SECTION("The first sample primes the filter")
+  {
+    for(auto i=0; i < 10; ++i)
+    {
+      REQUIRE(filter.filter(1000.0f) == Catch::Approx(1000.0f));
+    }
+  }
+
+  SECTION("Oscillation above the cutoff is suppressed")
+  {
+    float output = 0;
+    for(auto i=0; i < 200; ++i)
+    {
+      output = filter.filter(i % 2 ? 25.0f : 5.0f);
+    }
+    REQUIRE(output == Catch::Approx(15.0f).epsilon(1e-3));
+  }
+
+  SECTION("The bank filters each channel like a single cascade")
+  {
+    BiquadCascade<float, 2> other{coefficients};
+    BiquadCascadeBank<float, 2, 2> bank{coefficients};
+    for(auto i=0; i < 100; ++i)
+    {
+      const auto a = 1000.0f - float(i % 7);
+      const auto b = float((i * 13) % 17);
+      std::array<float, 2> sample{a, b};
+      bank.filter(sample);
+      REQUIRE(sample[0] == filter.filter(a));
+      REQUIRE(sample[1] == other.filter(b));
+    }
+  }
+}
+
+TEST_CASE("Polyphase resampling", "[filters]")
+{
+  SECTION("Windowed sinc taps are symmetric and normalized")
+  {
+    constexpr auto taps = windowed_sinc_lowpass<double, 31>(0.1);
+    double sum = 0;
+    for(size_t i=0; i < taps.size(); ++i)
+    {
+      REQUIRE(taps[i] == Catch::Approx(taps[taps.size() - 1 - i]));
+      sum += taps[i];
+    }
+    REQUIRE(sum == Catch::Approx(1.0));
+  }
+
+  SECTION("Decimation keeps every Factor-th sample and DC")
+  {
+    Decimator<float, 4, 16> decimator;
+    std::vector<float> output;
+    std::vector<float> input(40, 1000.0f);
+    decimator.update(input.begin(), input.end(), std::back_inserter(output));
+    REQUIRE(output.size() == 10);
+    for(const auto value : output)
+    {
+      REQUIRE(value == Catch::Approx(1000.0f));
+    }
+  }
+
+  SECTION("Decimation removes what would alias")
+  {
+    Decimator<double, 4, 16> decimator;
+    std::vector<double> output;
+    for(auto i=0; i < 400; ++i)
+    {
+      // 0.4 of the input rate would alias to DC after decimation
+      const auto value = 10.0 + std::cos(2 * M_PI * 0.4 * i);
+      decimator.update(value, std::back_inserter(output));
+    }
+    for(size_t i=20; i < output.size(); ++i)
+    {
+      REQUIRE(output[i] == Catch::Approx(10.0).margin(1e-3));
+    }
+  }
+
+  SECTION("Large factors still remove what would alias")
+  {
+    // The lowpass grows with the factor, so the band folding onto
+    // the passband stays attenuated by more than 60dB. 0.6 of the
+    // output rate is its lower edge, 1.0 lands right on DC.
+    constexpr int FACTOR = 50;
+    using test_t = Decimator<double, FACTOR, 16>;
+    static_assert(test_t::TAPS == FACTOR * 16);
+    for(const auto frequency : {0.6 / FACTOR, 1.0 / FACTOR, 1.4 / FACTOR})
+    {
+      test_t decimator;
+      std::vector<double> output;
+      for(auto i=0; i < 200 * FACTOR; ++i)
+      {
+        const auto value = 10.0 + std::cos(2 * M_PI * frequency * i);
+        decimator.update(value, std::back_inserter(output));
+      }
+      for(size_t i=40; i < output.size(); ++i)
+      {
+        REQUIRE(output[i] == Catch::Approx(10.0).margin(1e-3));
+      }
+    }
+  }
+
+  SECTION("Slow signals pass delayed by the group delay")
+  {
+    using test_t = PolyphaseResampler<double, 3, 2, 12>;
+    test_t resampler;
+    std::vector<double> output;
+    const auto signal = [](double t) { return std::sin(2 * M_PI * 0.01 * t); };
+    for(auto i=0; i < 600; ++i)
+    {
+      resampler.update(signal(i), std::back_inserter(output));
+    }
+    REQUIRE(output.size() == 900);
+    for(size_t m=100; m < output.size(); ++m)
+    {
+      // Output m sits at input time m * 2 / 3
+      const auto t = m * 2.0 / 3.0 - test_t::GROUP_DELAY;
+      REQUIRE(output[m] == Catch::Approx(signal(t)).margin(1e-2));
+    }
+  }
+}
+
+TEST_CASE("Savitzky-Golay filter", "[filters]")
+{
+  const auto parabola = [](double t) { return 1000.0 - 3.0 * t + 0.25 * t * t; };
+
+  SECTION("The classic 5 point quadratic smoothing coefficients")
+  {
+    constexpr auto coefficients = savitzky_golay_coefficients<double, 5, 2, 2>();
+    const double expected[] = { -3, 12, 17, 12, -3 };
+    for(auto k=0; k < 5; ++k)
+    {
+      REQUIRE(coefficients[0][k] == Catch::Approx(expected[k] / 35.0));
+    }
+  }
+
+  SECTION("A parabola and its derivatives are recovered at the window center")
+  {
+    SavitzkyGolayFilter<double, 9, 2> filter{0.1};
+    std::optional<savitzky_golay_t<double>> result;
+    for(auto i=0; i < 20; ++i)
+    {
+      result = filter.update(parabola(i * 0.1));
+    }
+    // The center lags the newest sample (19) by 4
+    const auto t = 15 * 0.1;
+    REQUIRE(result->value == Catch::Approx(parabola(t)));
+    REQUIRE(result->first_derivative == Catch::Approx(-3.0 + 0.5 * t));
+    REQUIRE(result->second_derivative == Catch::Approx(0.5));
+  }
+
+  SECTION("A causal filter evaluates at the newest sample")
+  {
+    SavitzkyGolayFilter<double, 11, 3, 0> filter{0.05};
+    std::optional<savitzky_golay_t<double>> result;
+    for(auto i=0; i < 11; ++i)
+    {
+      result = filter.update(parabola(i * 0.05));
+    }
+    const auto t = 10 * 0.05;
+    REQUIRE(result->value == Catch::Approx(parabola(t)));
+    REQUIRE(result->first_derivative == Catch::Approx(-3.0 + 0.5 * t));
+    REQUIRE(result->second_derivative == Catch::Approx(0.5));
+  }
+
+  SECTION("Noise is smoothed")
+  {
+    SavitzkyGolayFilter<float, 21, 2> filter;
+    std::optional<savitzky_golay_t<float>> result;
+    for(auto i=0; i < 30; ++i)
+    {
+      result = filter.update(i % 2 ? 1001.0f : 999.0f);
+    }
+    REQUIRE(result->value == Catch::Approx(1000.0f).epsilon(1e-4));
+    REQUIRE(std::abs(result->first_derivative) < 0.1f);
+  }
+
+  SECTION("A linear fit has no second derivative")
+  {
+    SavitzkyGolayFilter<double, 5, 1> filter;
+    std::optional<savitzky_golay_t<double>> result;
+    for(auto i=0; i < 5; ++i)
+    {
+      result = filter.update(2.0 * i);
+    }
+    REQUIRE(result->first_derivative == Catch::Approx(2.0));
+    REQUIRE(result->second_derivative == 0.0);
+  }
+}
@@ -0,0 +1,84 @@
+#include "histogram.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+using namespace deets::statistics;
+
+TEST_CASE("Histogram", "[histogram]")
+{
+  using test_t = Histogram<4, 20>;
+  test_t histogram;
+
+  SECTION("An empty histogram reports zeros")
+  {
+    REQUIRE(histogram.total() == 0);
+    REQUIRE(histogram.percentile(50) == 0);
+    REQUIRE(histogram.min() == 0);
+  }
+
+  SECTION("Small values are exact")
+  {
+    for(uint64_t i=0; i < 16; ++i)
+    {
+      REQUIRE(test_t::index(i) == i);
+      REQUIRE(test_t::lowest_equivalent(i) == i);
+      REQUIRE(test_t::highest_equivalent(i) == i);
+    }
+  }
+
+  SECTION("Buckets cover all values with bounded relative error")
+  {
+    for(uint64_t value=1; value < (1 << 20); value = value * 3 / 2 + 1)
+    {
+      const auto index = test_t::index(value);
+      REQUIRE(test_t::lowest_equivalent(index) <= value);
+      REQUIRE(test_t::highest_equivalent(index) >= value);
+      const auto width = test_t::highest_equivalent(index) - test_t::lowest_equivalent(index) + 1;
+      REQUIRE((width == 1 || double(width) / double(value) <= 1.0 / 16));
+    }
+  }
+
+  SECTION("Percentiles of a uniform distribution")
+  {
+    for(uint64_t value=1; value <= 10000; ++value)
+    {
+      histogram.record(value);
+    }
+    REQUIRE(histogram.total() == 10000);
+    REQUIRE(histogram.min() == 1);
+    REQUIRE(histogram.max() == 10000);
+    REQUIRE(histogram.mean() == Catch::Approx(5000.5));
+    REQUIRE(histogram.percentile(50) == Catch::Approx(5000).epsilon(1.0 / 16));
+    REQUIRE(histogram.percentile(99) == Catch::Approx(9900).epsilon(1.0 / 16));
+    REQUIRE(histogram.percentile(100) == 10000);
+  }
+
+  SECTION("The tail is visible")
+  {
+    histogram.record(100, 999);
+    histogram.record(50000);
+    // Percentiles report the upper end of their bucket
+    REQUIRE(histogram.percentile(99) == test_t::highest_equivalent(test_t::index(100)));
+    REQUIRE(histogram.percentile(99.95) >= 50000 * 15 / 16);
+  }
+
+  SECTION("Values beyond the range are clamped")
+  {
+    histogram.record(uint64_t(1) << 40);
+    REQUIRE(histogram.max() == test_t::HIGHEST_TRACKABLE);
+  }
+
+  SECTION("Merging adds up counts")
+  {
+    test_t other;
+    histogram.record(10, 3);
+    other.record(10, 2);
+    other.record(1000);
+    histogram.merge(other);
+    REQUIRE(histogram.total() == 6);
+    REQUIRE(histogram.count_at(10) == 5);
+    REQUIRE(histogram.max() == 1000);
+    REQUIRE(histogram.min() == 10);
+  }
+}
@@ -0,0 +1,105 @@
+#include "spsc-ring.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+using namespace deets::concurrent;
+
+TEST_CASE("SPSC ring", "[ring]")
+{
+  using test_t = SpscRing<int, 8>;
+  test_t ring;
+  int value = 0;
+
+  SECTION("Values come out in order")
+  {
+    REQUIRE_FALSE(ring.pop(value));
+    for(int i=0; i < 5; ++i)
+    {
+      REQUIRE(ring.push(i));
+    }
+    REQUIRE(ring.size() == 5);
+    for(int i=0; i < 5; ++i)
+    {
+      REQUIRE(ring.pop(value));
+      REQUIRE(value == i);
+    }
+    REQUIRE(ring.size() == 0);
+  }
+
+  SECTION("A full ring counts overruns")
+  {
+    for(int i=0; i < 10; ++i)
+    {
+      ring.push(i);
+    }
+    REQUIRE(ring.size() == 8);
+    REQUIRE(ring.overruns() == 2);
+    REQUIRE(ring.pop(value));
+    REQUIRE(ring.high_water_mark() == 8);
+  }
+
+  SECTION("Batches wrap around the end")
+  {
+    std::array<int, 8> out;
+    for(int i=0; i < 6; ++i)
+    {
+      ring.push(i);
+    }
+    REQUIRE(ring.pop(out.data(), 4) == 4);
+    for(int i=6; i < 12; ++i)
+    {
+      REQUIRE(ring.push(i));
+    }
+    REQUIRE(ring.pop(out.data(), out.size()) == 8);
+    for(int i=0; i < 8; ++i)
+    {
+      REQUIRE(out[i] == i + 4);
+    }
+    REQUIRE(ring.pop(out.data(), out.size()) == 0);
+    REQUIRE(ring.overruns() == 0);
+  }
+
+  SECTION("Producer and consumer can run on different threads")
+  {
+    SpscRing<uint32_t, 64> shared;
+    constexpr uint32_t COUNT = 200000;
+    std::thread producer([&shared]()
+    {
+      for(uint32_t i=0; i < COUNT;)
+      {
+        if(shared.push(i))
+        {
+          ++i;
+        }
+        else
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+    std::vector<uint32_t> received;
+    std::array<uint32_t, 16> batch;
+    while(received.size() < COUNT)
+    {
+      const auto popped = shared.pop(batch.data(), batch.size());
+      received.insert(received.end(), batch.begin(), batch.begin() + popped);
+      if(popped == 0)
+      {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+    bool ordered = true;
+    for(uint32_t i=0; i < received.size(); ++i)
+    {
+      ordered = ordered && received[i] == i;
+    }
+    REQUIRE(received.size() == COUNT);
+    REQUIRE(ordered);
+    REQUIRE(shared.high_water_mark() <= 64);
+  }
+}
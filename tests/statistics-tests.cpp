@@ -3,6 +3,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 #include <sstream>
+#include <ratio>
+#include <chrono>
+#include <vector>
+#include <memory_resource>
+#include <cstddef>
 
 using namespace deets::statistics;
 
@@ -137,3 +142,632 @@ TEST_CASE("Array statistics with float", "[statistics]")
 TEST_CASE("Parabola fitting")
 {
 }
+
+TEST_CASE("Exponential statistics", "[statistics]")
+{
+  using test_t = ExponentialStatistics<double, std::ratio<1, 4>, 3>;
+  test_t stats{10.0, 0.0};
+
+  SECTION("Only after confidence is reached, we get values")
+  {
+    REQUIRE(stats.update(10.0) == std::nullopt);
+    REQUIRE(stats.update(10.0) == std::nullopt);
+    const auto result = *stats.update(10.0);
+    REQUIRE(result.average == 10.0);
+    REQUIRE(result.variance == 0.0);
+  }
+
+  SECTION("The average follows a step with the given decay")
+  {
+    stats.update(14.0);
+    REQUIRE(stats.average == 11.0);
+    REQUIRE(stats.variance == Catch::Approx(3.0));
+    stats.update(14.0);
+    REQUIRE(stats.average == 11.75);
+  }
+
+  SECTION("Converges towards the actual statistics")
+  {
+    std::optional<test_t::result_t> result;
+    for(auto i=0; i < 1000; ++i)
+    {
+      result = stats.update(i % 2 ? 11.0 : 9.0);
+    }
+    REQUIRE(result->average == Catch::Approx(10.0).epsilon(0.2));
+    REQUIRE(result->variance == Catch::Approx(1.0).epsilon(0.2));
+  }
+}
+
+TEST_CASE("Timed exponential statistics", "[statistics]")
+{
+  using namespace std::chrono_literals;
+  using test_t = TimedExponentialStatistics<double, std::chrono::milliseconds>;
+  test_t stats{30ms, 10.0, 0.0};
+
+  SECTION("The weight of a sample depends on the elapsed time")
+  {
+    stats.update(14.0, 10ms);
+    REQUIRE(stats.average == 11.0);
+    stats.update(14.0, 30ms);
+    REQUIRE(stats.average == 12.5);
+  }
+
+  SECTION("Regular intervals match the fixed variant")
+  {
+    ExponentialStatistics<double, std::ratio<1, 4>> fixed{10.0, 0.0};
+    for(auto i=0; i < 20; ++i)
+    {
+      const auto value = double(i % 3);
+      stats.update(value, 10ms);
+      fixed.update(value);
+    }
+    REQUIRE(stats.average == Catch::Approx(fixed.average));
+    REQUIRE(stats.variance == Catch::Approx(fixed.variance));
+  }
+}
+
+TEST_CASE("Sliding minimum and maximum", "[statistics]")
+{
+  SlidingMinimum<float, 3> minimum;
+  SlidingMaximum<float, 3> maximum;
+
+  SECTION("Only return values after the window has been filled once")
+  {
+    REQUIRE(minimum.update(1.0) == std::nullopt);
+    REQUIRE(minimum.update(2.0) == std::nullopt);
+    REQUIRE(minimum.update(3.0) != std::nullopt);
+  }
+
+  SECTION("Extrema leave the window")
+  {
+    const float values[] = { 5, 1, 4, 3, 2, 6, 0, 7 };
+    const float minima[] = { 5, 1, 1, 1, 2, 2, 0, 0 };
+    const float maxima[] = { 5, 5, 5, 4, 4, 6, 6, 7 };
+    for(auto i=0; i < 8; ++i)
+    {
+      minimum.update(values[i]);
+      maximum.update(values[i]);
+      REQUIRE(minimum.extremum() == minima[i]);
+      REQUIRE(maximum.extremum() == maxima[i]);
+    }
+  }
+
+  SECTION("Matches a brute force window on a long sequence")
+  {
+    std::array<float, 200> values;
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      values[i] = float((i * 7919) % 101);
+    }
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      const auto result = minimum.update(values[i]);
+      if(i >= 2)
+      {
+        REQUIRE(*result == *std::min_element(&values[i - 2], &values[i + 1]));
+      }
+    }
+  }
+}
+
+TEST_CASE("Rolling regression", "[statistics]")
+{
+  using test_t = RollingRegression<float, 10>;
+  test_t regression;
+
+  SECTION("Only return values after the window has been filled once")
+  {
+    for(auto i=0; i < 9; ++i)
+    {
+      REQUIRE(regression.update(float(i), 1.0) == std::nullopt);
+    }
+    REQUIRE(regression.update(9.0, 1.0) != std::nullopt);
+  }
+
+  SECTION("A line is recovered")
+  {
+    std::optional<test_t::result_t> result;
+    for(auto i=0; i < 10; ++i)
+    {
+      result = regression.update(float(i), 3.0f - 0.5f * i);
+    }
+    REQUIRE(result->slope == Catch::Approx(-0.5));
+    REQUIRE(result->intercept == Catch::Approx(3.0));
+  }
+
+  SECTION("The slope follows a change in trend")
+  {
+    std::optional<test_t::result_t> result;
+    for(auto i=0; i < 30; ++i)
+    {
+      result = regression.update(float(i), i < 15 ? float(i) : 30.0f - i);
+    }
+    REQUIRE(result->slope == Catch::Approx(-1.0));
+    REQUIRE((*result)(29.0) == Catch::Approx(1.0));
+  }
+
+  SECTION("Float precision holds over long runs at large offsets")
+  {
+    RollingRegression<float, 100> long_regression;
+    std::optional<test_t::result_t> result;
+    for(auto i=0; i < 100000; ++i)
+    {
+      const auto t = i * 0.01f;
+      result = long_regression.update(t, 1000.0f - 0.25f * t);
+    }
+    REQUIRE(result->slope == Catch::Approx(-0.25).epsilon(0.01));
+  }
+}
+
+TEST_CASE("Rolling quadratic fit", "[statistics]")
+{
+  using test_t = RollingQuadraticFit<float, 20>;
+  test_t fit;
+  std::optional<test_t::result_t> result;
+
+  SECTION("Only return values after the window has been filled once")
+  {
+    for(auto i=0; i < 19; ++i)
+    {
+      REQUIRE(fit.update(float(i), 1.0) == std::nullopt);
+    }
+    REQUIRE(fit.update(19.0, 1.0) != std::nullopt);
+  }
+
+  SECTION("A parabola is recovered")
+  {
+    for(auto i=0; i < 45; ++i)
+    {
+      const auto x = i * 0.1f;
+      result = fit.update(x, 2.0f - 1.5f * x + 0.75f * x * x);
+    }
+    REQUIRE(result->second_derivative() == Catch::Approx(1.5).epsilon(1e-3));
+    REQUIRE((*result)(4.0f) == Catch::Approx(2.0 - 6.0 + 12.0).epsilon(1e-4));
+    REQUIRE((*result)(3.0f) == Catch::Approx(2.0 - 4.5 + 6.75).epsilon(1e-4));
+    REQUIRE(result->f_statistic > 1000);
+  }
+
+  SECTION("A noisy line isn't mistaken for a parabola")
+  {
+    for(auto i=0; i < 60; ++i)
+    {
+      const auto x = i * 0.05f;
+      const auto noise = (i % 2 ? 0.1f : -0.1f) * float((i * 7) % 5) / 4.0f;
+      result = fit.update(x, 980.0f + 1.2f * x + noise);
+    }
+    REQUIRE(result->c == Catch::Approx(0.0).margin(0.1));
+    REQUIRE(result->f_statistic < 4.0);
+  }
+
+  SECTION("Float precision holds over long runs at large offsets")
+  {
+    RollingQuadraticFit<float, 50> long_fit;
+    for(auto i=0; i < 100000; ++i)
+    {
+      const auto t = i * 0.01f;
+      const auto dt = t - 950.0f;
+      result = long_fit.update(t, 1000.0f + 0.5f * dt * dt);
+    }
+    REQUIRE(result->second_derivative() == Catch::Approx(1.0).epsilon(0.05));
+  }
+}
+
+TEST_CASE("Sliding median", "[statistics]")
+{
+  SlidingMedian<float, 5> median;
+
+  SECTION("Only return values after the window has been filled once")
+  {
+    for(auto i=0; i < 4; ++i)
+    {
+      REQUIRE(median.update(float(i)) == std::nullopt);
+    }
+    REQUIRE(*median.update(4.0) == 2.0f);
+  }
+
+  SECTION("Median and MAD follow the window")
+  {
+    const float values[] = { 3, 1, 100, 2, 4, 5, 5 };
+    for(const auto value : values)
+    {
+      median.update(value);
+    }
+    // Window is 100, 2, 4, 5, 5
+    REQUIRE(median.median() == 5.0f);
+    // Deviations are 95, 3, 1, 0, 0
+    REQUIRE(median.mad() == 1.0f);
+  }
+
+  SECTION("Matches a sorted copy on a long sequence")
+  {
+    std::array<float, 300> values;
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      values[i] = float((i * 7919) % 37);
+    }
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      const auto result = median.update(values[i]);
+      if(i >= 4)
+      {
+        std::array<float, 5> window;
+        std::copy(&values[i - 4], &values[i + 1], window.begin());
+        std::sort(window.begin(), window.end());
+        const auto expected = window[2];
+        REQUIRE(*result == expected);
+        for(auto& value : window)
+        {
+          value = std::abs(value - expected);
+        }
+        std::sort(window.begin(), window.end());
+        REQUIRE(median.mad() == window[2]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Integer square root", "[statistics]")
+{
+  REQUIRE(isqrt(0) == 0);
+  REQUIRE(isqrt(1) == 1);
+  REQUIRE(isqrt(15) == 3);
+  REQUIRE(isqrt(16) == 4);
+  REQUIRE(isqrt(int64_t(1) << 62) == int64_t(1) << 31);
+  static_assert(isqrt(uint32_t(1000000)) == 1000, "isqrt is constexpr");
+}
+
+TEST_CASE("Integer array statistics", "[statistics]")
+{
+  using test_t = IntegerArrayStatistics<int32_t, 8>;
+  test_t stats;
+
+  SECTION("Only return values after array has been filled once")
+  {
+    for(auto i=0; i < 7; ++i)
+    {
+      REQUIRE(stats.update(10) == std::nullopt);
+    }
+    REQUIRE(stats.update(10) != std::nullopt);
+  }
+
+  SECTION("Matches the floating point statistics")
+  {
+    ArrayStatistics<double, 8> reference;
+    std::optional<test_t::result_t> result;
+    std::optional<ArrayStatistics<double, 8>::result_t> expected;
+    for(auto i=0; i < 100; ++i)
+    {
+      const auto value = int32_t((i * 7919) % 97) - 40;
+      result = stats.update(value);
+      expected = reference.update(value);
+    }
+    REQUIRE(result->average == int32_t(std::floor(expected->average)));
+    REQUIRE(result->variance == int64_t(expected->variance));
+  }
+
+  SECTION("Non power of two windows work as well")
+  {
+    IntegerArrayStatistics<int16_t, 10> decimal;
+    std::optional<IntegerArrayStatistics<int16_t, 10>::result_t> result;
+    for(int16_t i=1; i < 11; ++i)
+    {
+      result = decimal.update(i);
+    }
+    REQUIRE(result->average == 5);
+    REQUIRE(result->variance == 9);
+    REQUIRE(result->stddev() == 3);
+  }
+
+  SECTION("Q-format pressures")
+  {
+    using q_t = q_format<8>;
+    std::optional<test_t::result_t> result;
+    for(auto i=0; i < 8; ++i)
+    {
+      result = stats.update(q_t::from(995.5 + (i % 2 ? 0.25 : -0.25)));
+    }
+    REQUIRE(q_t::to(result->average) == 995.5);
+    REQUIRE(q_t::to_variance(result->variance) == Catch::Approx(0.0714).epsilon(0.01));
+    REQUIRE(q_t::to(result->stddev()) == Catch::Approx(0.265).epsilon(0.02));
+  }
+}
+
+TEST_CASE("Summation policies", "[statistics]")
+{
+  // 0.1 isn't representable, so each of these additions
+  // rounds, and naive float summation drifts visibly.
+  std::vector<float> values(100000, 1000.1f);
+  const double expected = 100000.0 * double(1000.1f);
+
+  SECTION("Naive summation drifts")
+  {
+    const auto sum = deets::statistics::reduce(values.begin(), values.end(), naive_summation{});
+    REQUIRE(std::abs(sum - expected) > 100.0);
+  }
+
+  SECTION("Compensated summation is exact to float precision")
+  {
+    const auto sum = deets::statistics::reduce(values.begin(), values.end(), compensated_summation{});
+    REQUIRE(sum == Catch::Approx(expected).epsilon(1e-7));
+  }
+
+  SECTION("Pairwise summation is exact to float precision")
+  {
+    const auto sum = deets::statistics::reduce(values.begin(), values.end(), pairwise_summation<>{});
+    REQUIRE(sum == Catch::Approx(expected).epsilon(1e-6));
+  }
+
+  SECTION("Pairwise summation handles ragged sizes")
+  {
+    for(size_t count=0; count < 300; count += 7)
+    {
+      std::vector<int> ints(count);
+      std::iota(ints.begin(), ints.end(), 1);
+      REQUIRE(deets::statistics::reduce(ints.begin(), ints.end(), pairwise_summation<16, 4>{}) == int(count * (count + 1) / 2));
+    }
+  }
+}
+
+TEST_CASE("Array statistics with compensated summation", "[statistics]")
+{
+  ArrayStatistics<float, 4096, compensated_summation> compensated;
+  ArrayStatistics<double, 4096> reference;
+  std::optional<ArrayStatistics<float, 4096>::result_t> result;
+  std::optional<ArrayStatistics<double, 4096>::result_t> expected;
+  for(auto i=0; i < 4096; ++i)
+  {
+    const auto value = 1000.0f + float(i % 10) * 0.01f;
+    result = compensated.update(value);
+    expected = reference.update(value);
+  }
+  REQUIRE(result->average == Catch::Approx(expected->average).epsilon(1e-7));
+  REQUIRE(result->variance == Catch::Approx(expected->variance).epsilon(1e-3));
+}
+
+TEST_CASE("Rolling multivariate statistics", "[statistics]")
+{
+  using test_t = RollingMultivariateStatistics<double, 2, 10>;
+  using sample_t = std::array<double, 2>;
+  test_t stats;
+
+  SECTION("Only return values after the window has been filled once")
+  {
+    for(auto i=0; i < 9; ++i)
+    {
+      REQUIRE(stats.update(sample_t{1.0, 2.0}) == std::nullopt);
+    }
+    REQUIRE(stats.update(sample_t{1.0, 2.0}) != std::nullopt);
+  }
+
+  SECTION("Matches the single channel statistics")
+  {
+    ArrayStatistics<double, 10> first, second;
+    std::optional<test_t::result_t> result;
+    std::optional<ArrayStatistics<double, 10>::result_t> first_result, second_result;
+    for(auto i=0; i < 35; ++i)
+    {
+      const auto a = 1000.0 + (i * 7919) % 13;
+      const auto b = double((i * 104729) % 17);
+      result = stats.update(sample_t{a, b});
+      first_result = first.update(a);
+      second_result = second.update(b);
+    }
+    REQUIRE(result->average[0] == Catch::Approx(first_result->average));
+    REQUIRE(result->average[1] == Catch::Approx(second_result->average));
+    REQUIRE(result->variance(0) == Catch::Approx(first_result->variance));
+    REQUIRE(result->variance(1) == Catch::Approx(second_result->variance));
+    REQUIRE(result->covariance[1] == result->covariance[2]);
+  }
+
+  SECTION("Correlation of linearly related channels")
+  {
+    std::optional<test_t::result_t> result;
+    for(auto i=0; i < 25; ++i)
+    {
+      const auto a = double(i % 7);
+      result = stats.update(sample_t{a, 3.0 - 2.0 * a});
+    }
+    REQUIRE(result->correlation(0, 1) == Catch::Approx(-1.0));
+    REQUIRE(result->correlation(0, 0) == Catch::Approx(1.0));
+  }
+}
+
+TEST_CASE("Batch updates match scalar updates", "[statistics]")
+{
+  std::vector<float> values(137);
+  for(size_t i=0; i < values.size(); ++i)
+  {
+    values[i] = 1000.0f + float((i * 7919) % 23) * 0.1f;
+  }
+
+  SECTION("Rolling statistics")
+  {
+    RollingStatistics<float, 10> scalar{1000.0, 1.0}, batch{1000.0, 1.0};
+    std::optional<RollingStatistics<float, 10>::result_t> expected;
+    for(const auto value : values)
+    {
+      expected = scalar.update(value);
+    }
+    const auto result = batch.update(values.begin(), values.end());
+    REQUIRE(result->average == expected->average);
+    REQUIRE(result->variance == expected->variance);
+  }
+
+  SECTION("Exponential statistics")
+  {
+    using test_t = ExponentialStatistics<float, std::ratio<1, 8>>;
+    test_t scalar{1000.0, 0.0}, batch{1000.0, 0.0};
+    std::optional<test_t::result_t> expected;
+    for(const auto value : values)
+    {
+      expected = scalar.update(value);
+    }
+    const auto result = batch.update(values.begin(), values.end());
+    REQUIRE(result->average == expected->average);
+    REQUIRE(result->variance == expected->variance);
+  }
+
+  SECTION("Timed exponential statistics")
+  {
+    using namespace std::chrono_literals;
+    using test_t = TimedExponentialStatistics<float, std::chrono::milliseconds>;
+    test_t scalar{50ms, 1000.0, 0.0}, batch{50ms, 1000.0, 0.0};
+    std::vector<std::chrono::milliseconds> elapsed(values.size());
+    std::optional<test_t::result_t> expected;
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      elapsed[i] = std::chrono::milliseconds(5 + i % 4);
+      expected = scalar.update(values[i], elapsed[i]);
+    }
+    const auto result = batch.update(values.begin(), values.end(), elapsed.begin());
+    REQUIRE(result->average == expected->average);
+    REQUIRE(result->variance == expected->variance);
+  }
+
+  SECTION("Array statistics")
+  {
+    ArrayStatistics<float, 10> scalar, batch;
+    std::optional<ArrayStatistics<float, 10>::result_t> expected;
+    for(const auto value : values)
+    {
+      expected = scalar.update(value);
+    }
+    REQUIRE(batch.update(values.begin(), values.begin() + 5) == std::nullopt);
+    const auto result = batch.update(values.begin() + 5, values.end());
+    REQUIRE(result->average == expected->average);
+    REQUIRE(result->variance == expected->variance);
+  }
+
+  SECTION("Integer array statistics")
+  {
+    IntegerArrayStatistics<int32_t, 16> scalar, batch;
+    std::vector<int32_t> ints(values.size());
+    std::optional<IntegerArrayStatistics<int32_t, 16>::result_t> expected;
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      ints[i] = q_format<8>::from(values[i]);
+      expected = scalar.update(ints[i]);
+    }
+    const auto result = batch.update(ints.begin(), ints.end());
+    REQUIRE(result->average == expected->average);
+    REQUIRE(result->variance == expected->variance);
+  }
+
+  SECTION("Sliding median and extremum")
+  {
+    SlidingMedian<float, 9> scalar_median, batch_median;
+    SlidingMaximum<float, 9> scalar_maximum, batch_maximum;
+    for(const auto value : values)
+    {
+      scalar_median.update(value);
+      scalar_maximum.update(value);
+    }
+    REQUIRE(*batch_median.update(values.begin(), values.end()) == scalar_median.median());
+    REQUIRE(batch_median.mad() == scalar_median.mad());
+    REQUIRE(*batch_maximum.update(values.begin(), values.end()) == scalar_maximum.extremum());
+  }
+
+  SECTION("Rolling regression")
+  {
+    RollingRegression<float, 20> scalar, batch;
+    std::vector<float> xs(values.size());
+    std::optional<RollingRegression<float, 20>::result_t> expected;
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      xs[i] = float(i) * 0.01f;
+      expected = scalar.update(xs[i], values[i]);
+    }
+    const auto result = batch.update(xs.begin(), xs.end(), values.begin());
+    REQUIRE(result->slope == expected->slope);
+    REQUIRE(result->intercept == expected->intercept);
+  }
+
+  SECTION("Rolling multivariate statistics")
+  {
+    using test_t = RollingMultivariateStatistics<float, 2, 12>;
+    test_t scalar, batch;
+    std::vector<std::array<float, 2>> samples(values.size());
+    std::optional<test_t::result_t> expected;
+    for(size_t i=0; i < values.size(); ++i)
+    {
+      samples[i] = { values[i], float(i % 5) };
+      expected = scalar.update(samples[i]);
+    }
+    const auto result = batch.update(samples.begin(), samples.end());
+    REQUIRE(result->average == expected->average);
+    REQUIRE(result->covariance == expected->covariance);
+  }
+}
+
+TEST_CASE("Runtime sized windows", "[statistics]")
+{
+  // Everything has to fit, there's no upstream to fall back to
+  std::array<std::byte, 4096> arena;
+  std::pmr::monotonic_buffer_resource resource{arena.data(), arena.size(), std::pmr::null_memory_resource()};
+
+  SECTION("Array statistics match the compile time version")
+  {
+    ArrayStatistics<double, 10> reference;
+    DynamicArrayStatistics<double> stats{10, &resource};
+    std::optional<ArrayStatistics<double, 10>::result_t> expected;
+    for(auto i=0; i < 37; ++i)
+    {
+      const auto value = std::sin(i * 0.3) * 100.0;
+      expected = reference.update(value);
+      const auto result = stats.update(value);
+      REQUIRE(result.has_value() == expected.has_value());
+      if(expected)
+      {
+        REQUIRE(result->average == Catch::Approx(expected->average));
+        REQUIRE(result->variance == Catch::Approx(expected->variance));
+      }
+    }
+    REQUIRE(*stats.median() == *reference.median());
+
+    // The median sorts the window, both carry on the same way
+    for(auto i=0; i < 7; ++i)
+    {
+      const auto value = std::cos(i * 0.7) * 50.0;
+      REQUIRE(stats.update(value)->average == Catch::Approx(reference.update(value)->average));
+    }
+    REQUIRE(stats.values == std::pmr::vector<double>(reference.values.begin(), reference.values.end()));
+  }
+
+  SECTION("Rolling statistics match the compile time version")
+  {
+    RollingStatistics<double, 10, 3> reference{10.0, 1.0};
+    DynamicRollingStatistics<double> stats{10, 3, 10.0, 1.0};
+    for(auto i=0; i < 37; ++i)
+    {
+      const auto value = 10.0 + std::sin(i * 0.3);
+      const auto expected = reference.update(value);
+      const auto result = stats.update(value);
+      REQUIRE(result.has_value() == expected.has_value());
+      if(expected)
+      {
+        REQUIRE(result->average == expected->average);
+        REQUIRE(result->variance == expected->variance);
+      }
+    }
+  }
+
+  SECTION("Many windows share one block")
+  {
+    std::vector<DynamicArrayStatistics<float>> detectors;
+    for(size_t size : {2, 10, 50, 100})
+    {
+      detectors.emplace_back(size, &resource);
+    }
+    for(auto& detector : detectors)
+    {
+      const auto begin = reinterpret_cast<std::byte*>(detector.values.data());
+      REQUIRE(begin >= arena.data());
+      REQUIRE(begin + detector.values.size() * sizeof(float) <= arena.data() + arena.size());
+    }
+    const std::vector<float> block(100, 2.0f);
+    for(auto& detector : detectors)
+    {
+      REQUIRE(detector.update(block.begin(), block.end())->average == 2.0f);
+    }
+  }
+}